@@ -0,0 +1,254 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Scheduler.h"
+
+// admission control for a runtime that adds and removes tasks one at a time. it keeps the set
+// ranked the way RMSA ranks it, with the utilization, the hyperperiod and a lower bound on every
+// task's worst case response time, and a change only looks at the tasks it can affect:
+//   admit   the new task and everything below it. most of them are cleared in O(1) each by the
+//           response time upper bound of Bini et al., (C + sum C_j (1 - U_j)) / (1 - sum U_j)
+//           over the tasks above. a task that bound can't clear is cleared by a point it was
+//           seen to finish by before (one demand sum), if that still holds. only after both the
+//           exact iteration runs, started from its old response (more interference can only
+//           push it up)
+//   remove  the tasks below it get their lower bound lowered to their wcet plus the wcets above,
+//           the points they finish by stay good
+// so a decision is O(n) plus a sum or two for the few tasks that are tight. the set is always
+// schedulable: a task that would make any task miss is turned down and nothing changes
+//
+//   AdmissionAnalyzer cpu;
+//   if (cpu.admit("A", 1, 4).verdict == ADMIT_OK) ...
+//   cpu.response(0); // exact worst case response time of the highest priority task
+//   cpu.remove("A");
+
+enum AdmissionVerdict
+{
+    ADMIT_OK,
+    ADMIT_OVERLOAD,  // utilization would go over 1
+    ADMIT_MISS,      // some task would miss its deadline
+    ADMIT_INVALID,   // negative wcet or a period under 1
+    ADMIT_DUPLICATE  // a task of that name is already in
+};
+
+struct AdmissionDecision
+{
+    AdmissionVerdict verdict;
+    double utilization; // of the set with the task in, whether it got in or not
+    size_t rechecked;   // how many tasks needed the exact iteration
+};
+
+struct AdmittedTask
+{
+    std::string name;
+    long long wcet;
+    long long period;
+};
+
+struct AdmissionAnalyzer
+{
+    std::vector<SimTask> ranked;        // rate monotonic order, shorter period first, then by name
+    std::vector<std::string> names;     // names[k] belongs to ranked[k]
+    std::vector<long long> responses;   // at most the worst case response time of ranked[k], exact once response(k) ran
+    std::vector<long long> witnesses;   // a t within the period with demand(t) <= t, so ranked[k] is done by t. -1 for
+                                        // none yet. an admit above can break it, so it is checked before it is trusted
+    std::vector<AdmittedTask> arrivals; // in the order they got in, the utilization is summed in this order like RMSA does
+    std::map<long long, int> periods;   // how many tasks have each period
+    double utilization = 0;
+    long long hyperPeriod = 0;          // 0 while empty, HYPERPERIOD_OVERFLOW past 64 bits
+    std::vector<std::pair<size_t, long long>> trial; // exact responses of an admit that isn't decided yet
+
+    size_t size() const
+    {
+        return ranked.size();
+    }
+
+    // where a task goes in ranked, or where it is
+    size_t rankOf(long long period, std::string_view name) const
+    {
+        size_t low = 0, high = ranked.size();
+        while (low < high)
+        {
+            size_t mid = (low + high) / 2;
+            if (ranked[mid].period < period || (ranked[mid].period == period && names[mid] < name))
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // ranked.size() if there is no such task
+    size_t find(std::string_view name) const
+    {
+        for (size_t k = 0; k < arrivals.size(); k++)
+        {
+            if (arrivals[k].name == name)
+            {
+                return rankOf(arrivals[k].period, name);
+            }
+        }
+        return ranked.size();
+    }
+
+    // exact worst case response time of ranked[k], worked out from its lower bound and kept
+    long long response(size_t k)
+    {
+        responses[k] = taskResponse(ranked, k, responses[k]);
+        witnesses[k] = responses[k];
+        return responses[k];
+    }
+
+    // with keep false it only tells whether the task would get in and leaves the set alone
+    AdmissionDecision admit(std::string_view name, long long wcet, long long period, bool keep = true)
+    {
+        AdmissionDecision decision = { ADMIT_INVALID, utilization, 0 };
+        if (wcet < 0 || period < 1)
+        {
+            return decision;
+        }
+        if (find(name) != ranked.size())
+        {
+            decision.verdict = ADMIT_DUPLICATE;
+            return decision;
+        }
+
+        decision.utilization = utilization + (double)wcet / (double)period;
+        if (!(decision.utilization <= 1))
+        {
+            decision.verdict = ADMIT_OVERLOAD;
+            return decision;
+        }
+
+        size_t rank = rankOf(period, name);
+        ranked.insert(ranked.begin() + rank, SimTask{ wcet, period });
+
+        // load and carried are sum U_j and sum C_j (1 - U_j) over the tasks above i, above is sum C_j
+        double load = 0, carried = 0;
+        long long above = 0;
+        for (size_t j = 0; j < rank; j++)
+        {
+            double u = (double)ranked[j].wcet / (double)ranked[j].period;
+            load += u;
+            carried += ranked[j].wcet * (1 - u);
+            above += ranked[j].wcet;
+        }
+        long long lowest = wcet > 0 ? wcet + above : 0; // the new task's lower bound
+
+        // exact responses go into trial so a miss leaves the set as it was. the task now at
+        // i + 1 was at i before, its old response is still a lower bound
+        trial.clear();
+        for (size_t i = rank; i < ranked.size(); i++)
+        {
+            // the bound is in floating point, a task it only just clears goes to the exact test anyway
+            double bound = (ranked[i].wcet + carried) / (1 - load);
+            long long witness = i == rank ? -1 : witnesses[i - 1];
+            if (!(load < 1 && bound <= ranked[i].period * (1 - 1e-9))
+                && !(witness >= 0 && taskDemand(ranked, i, witness) <= witness))
+            {
+                long long exact = taskResponse(ranked, i, i == rank ? lowest : responses[i - 1]);
+                decision.rechecked++;
+                if (exact > ranked[i].period)
+                {
+                    ranked.erase(ranked.begin() + rank);
+                    decision.verdict = ADMIT_MISS;
+                    return decision;
+                }
+                trial.push_back({ i, exact });
+            }
+
+            double u = (double)ranked[i].wcet / (double)ranked[i].period;
+            load += u;
+            carried += ranked[i].wcet * (1 - u);
+        }
+
+        decision.verdict = ADMIT_OK;
+        if (!keep)
+        {
+            ranked.erase(ranked.begin() + rank);
+            return decision;
+        }
+
+        names.insert(names.begin() + rank, std::string(name));
+        responses.insert(responses.begin() + rank, lowest);
+        witnesses.insert(witnesses.begin() + rank, -1);
+        for (size_t k = 0; k < trial.size(); k++)
+        {
+            responses[trial[k].first] = trial[k].second;
+            witnesses[trial[k].first] = trial[k].second;
+        }
+        arrivals.push_back({ std::string(name), wcet, period });
+        utilization = decision.utilization;
+        if (periods[period]++ == 0)
+        {
+            hyperPeriod = hyperPeriod == 0 ? period : checkedLcm(hyperPeriod, period);
+        }
+        return decision;
+    }
+
+    // false if there is no such task. taking a task out can't make anything miss, the tasks
+    // below it only get their lower bounds lowered
+    bool remove(std::string_view name)
+    {
+        size_t rank = find(name);
+        if (rank == ranked.size())
+        {
+            return false;
+        }
+
+        long long period = ranked[rank].period;
+        ranked.erase(ranked.begin() + rank);
+        names.erase(names.begin() + rank);
+        responses.erase(responses.begin() + rank);
+        witnesses.erase(witnesses.begin() + rank);
+
+        // a response is at least the task's own wcet plus one job of every task above it
+        long long above = 0;
+        for (size_t j = 0; j < rank; j++)
+        {
+            above += ranked[j].wcet;
+        }
+        for (size_t i = rank; i < ranked.size(); i++)
+        {
+            responses[i] = ranked[i].wcet > 0 ? ranked[i].wcet + above : 0;
+            above += ranked[i].wcet;
+        }
+
+        // summed again rather than subtracted, so the utilization stays exactly what RMSA gets
+        for (size_t k = 0; k < arrivals.size(); k++)
+        {
+            if (arrivals[k].name == name)
+            {
+                arrivals.erase(arrivals.begin() + k);
+                break;
+            }
+        }
+        utilization = 0;
+        for (size_t k = 0; k < arrivals.size(); k++)
+        {
+            utilization += (double)arrivals[k].wcet / (double)arrivals[k].period;
+        }
+
+        // the hyperperiod only changes when the last task with this period goes
+        if (--periods[period] == 0)
+        {
+            periods.erase(period);
+            hyperPeriod = 0;
+            for (std::map<long long, int>::const_iterator it = periods.begin(); it != periods.end(); ++it)
+            {
+                hyperPeriod = hyperPeriod == 0 ? it->first : checkedLcm(hyperPeriod, it->first);
+            }
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <cmath>
+#include <vector>
+#include "Scheduler.h"
+
+// the analysis of one task set as RMSA does it, without the parsing and the report around it:
+//   1. the caller sums the utilization and checks it against 1 and the liu-layland bound
+//   2. decideSet: the response time test when the bound couldn't decide, and how much of the
+//      timeline a schedulable set gets simulated over
+//   3. simulateSet: the diagram, as run-length segments
+// PA3, PA3-OS and the C library in librms.h all go through here, so they can't disagree
+
+// the liu-layland bound n(2^(1/n) - 1), under it rate monotonic is schedulable without more tests
+inline double liuLaylandBound(size_t n)
+{
+    return n * (std::pow(2.0, 1.0 / n) - 1);
+}
+
+// everything worked out about a set past its utilization. tasks are referred to by their place in
+// rate monotonic order, the same way Segment::task does
+struct SetResult
+{
+    long long hyperPeriod;
+    bool schedulable;
+    std::vector<long long> responses; // response time test, empty if it didn't run
+    long long window;                 // how much of the timeline the schedule covers, 0 if not schedulable
+    std::vector<Segment> segments;    // the schedule, empty if the set isn't schedulable
+
+    size_t bytes() const
+    {
+        return sizeof(SetResult) + responses.capacity() * sizeof(long long) + segments.capacity() * sizeof(Segment);
+    }
+};
+
+// the lcm of the periods, HYPERPERIOD_OVERFLOW past 64 bits, 0 for no tasks. any task record
+// with a period will do, so PA3 and PA3-OS don't have to copy their sets into SimTasks first
+template <typename Task>
+long long setHyperPeriod(const std::vector<Task>& tasks)
+{
+    long long hyperPeriod = tasks.empty() ? 0 : tasks.front().period;
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        hyperPeriod = checkedLcm(hyperPeriod, tasks[k].period);
+    }
+    return hyperPeriod;
+}
+
+// overloaded is utilization over 1, needsExact utilization over the bound (and not overloaded).
+// ranked is the set in rate monotonic order
+inline void decideSet(const std::vector<SimTask>& ranked, bool overloaded, bool needsExact, long long hyperPeriod, long long windowLimit, SetResult& result)
+{
+    result.hyperPeriod = hyperPeriod;
+    result.schedulable = !overloaded;
+    result.responses.clear();
+    result.segments.clear();
+    if (!overloaded && needsExact)
+    {
+        result.schedulable = responseTimeAnalysis(ranked, result.responses);
+    }
+
+    // a hyperperiod that is too long only gets its level-1 busy period
+    result.window = result.schedulable ? simulationWindow(ranked, hyperPeriod, windowLimit) : 0;
+}
+
+// the schedule of a set decideSet found schedulable, over its window
+inline void simulateSet(const std::vector<SimTask>& ranked, SetResult& result)
+{
+    simulateRMS(ranked, result.window, [&](int task, long long start, long long length)
+    {
+        addSegment(result.segments, task, start, length);
+    });
+}
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef BATCH_BOUNDS_H
+#define BATCH_BOUNDS_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_BOUNDS_X86 1
+#endif
+
+// the cheap verdicts for a lot of task sets at once, without simulating anything:
+//   OVERLOADED   utilization over 1, never schedulable
+//   LIU_LAYLAND  under n(2^(1/n) - 1), schedulable under rate monotonic
+//   HYPERBOLIC   product of (u + 1) at most 2 (Bini's hyperbolic bound), also schedulable
+//   NEEDS_EXACT  none of the above, only the response time test can tell
+enum BoundVerdict : uint8_t
+{
+    OVERLOADED,
+    LIU_LAYLAND,
+    HYPERBOLIC,
+    NEEDS_EXACT,
+    VERDICT_COUNT
+};
+
+// task sets stored as structure of arrays: the wcets and periods of every set back to back,
+// set i being tasks [start[i], start[i + 1]). that's 8 bytes a task, and each lane of a kernel
+// streams through its own set
+struct TaskSetBatch
+{
+    std::vector<int32_t> wcet;
+    std::vector<int32_t> period;
+    std::vector<uint32_t> start;
+
+    TaskSetBatch() : start(1, 0) {}
+
+    size_t size() const
+    {
+        return start.size() - 1;
+    }
+
+    void clear()
+    {
+        wcet.clear();
+        period.clear();
+        start.assign(1, 0);
+    }
+
+    void addTask(int32_t c, int32_t t)
+    {
+        wcet.push_back(c);
+        period.push_back(t);
+    }
+
+    // closes the set that the tasks added since the last call belong to
+    void endSet()
+    {
+        start.push_back((uint32_t)wcet.size());
+    }
+};
+
+struct BoundResults
+{
+    std::vector<double> utilization;
+    std::vector<double> hyperbolic;  // product of (u + 1)
+    std::vector<uint8_t> verdict;    // a BoundVerdict per set
+    size_t counts[VERDICT_COUNT];    // how many sets got each verdict
+};
+
+enum BoundKernel
+{
+    KERNEL_BEST,   // AVX2 when the cpu has it, SSE2 otherwise, scalar off x86
+    KERNEL_SCALAR,
+    KERNEL_SSE2,
+    KERNEL_AVX2
+};
+
+// every kernel works across sets, one set per vector lane: lane l runs set i + l through its tasks
+// in order, and a lane whose set has run out adds a task of wcet 0 and period 1, which leaves its
+// sums as they are. each lane does what scalarSet does in the order it does it, and division is
+// exact, so scalar, SSE2 and AVX2 come out bit for bit the same and a set gets the same verdict
+// whichever one ran. a group of sets takes as long as its longest set, so the lanes are all busy
+// when the sets of a batch have about the same task count, as generated batches do
+inline void scalarSet(const TaskSetBatch& batch, size_t set, double& utilization, double& hyperbolic)
+{
+    utilization = 0;
+    hyperbolic = 1;
+    for (uint32_t j = batch.start[set]; j < batch.start[set + 1]; j++)
+    {
+        double u = (double)batch.wcet[j] / (double)batch.period[j];
+        utilization += u;
+        hyperbolic *= u + 1;
+    }
+}
+
+// the longest of the count sets from set on
+inline uint32_t longestSet(const TaskSetBatch& batch, size_t set, size_t count)
+{
+    uint32_t longest = 0;
+    for (size_t l = 0; l < count; l++)
+    {
+        uint32_t n = batch.start[set + l + 1] - batch.start[set + l];
+        longest = n > longest ? n : longest;
+    }
+    return longest;
+}
+
+#ifdef BATCH_BOUNDS_X86
+
+// sets set and set + 1, SSE2 has no gather so the two lanes are loaded one at a time. up to the
+// shorter set both lanes are live, past it the lanes check
+inline void sse2Sets(const TaskSetBatch& batch, size_t set, double* utilization, double* hyperbolic)
+{
+    __m128d sum = _mm_setzero_pd();
+    __m128d product = _mm_set1_pd(1);
+    __m128d one = _mm_set1_pd(1);
+
+    uint32_t a = batch.start[set], b = batch.start[set + 1];
+    uint32_t aLength = b - a, bLength = batch.start[set + 2] - b;
+    uint32_t shortest = aLength < bLength ? aLength : bLength;
+    uint32_t longest = aLength < bLength ? bLength : aLength;
+    for (uint32_t k = 0; k < longest; k++)
+    {
+        __m128d c, t;
+        if (k < shortest)
+        {
+            c = _mm_set_pd(batch.wcet[b + k], batch.wcet[a + k]);
+            t = _mm_set_pd(batch.period[b + k], batch.period[a + k]);
+        }
+        else
+        {
+            c = _mm_set_pd(k < bLength ? batch.wcet[b + k] : 0, k < aLength ? batch.wcet[a + k] : 0);
+            t = _mm_set_pd(k < bLength ? batch.period[b + k] : 1, k < aLength ? batch.period[a + k] : 1);
+        }
+        __m128d u = _mm_div_pd(c, t);
+        sum = _mm_add_pd(sum, u);
+        product = _mm_mul_pd(product, _mm_add_pd(u, one));
+    }
+
+    _mm_storeu_pd(utilization + set, sum);
+    _mm_storeu_pd(hyperbolic + set, product);
+}
+
+// sets set to set + 3, each lane gathering its next task straight out of the batch. the gather
+// takes signed 32 bit indices, evaluateBounds doesn't use this past 2^31 tasks
+__attribute__((target("avx2"))) inline void avx2Sets(const TaskSetBatch& batch, size_t set, double* utilization, double* hyperbolic)
+{
+    __m256d sum = _mm256_setzero_pd();
+    __m256d product = _mm256_set1_pd(1);
+    __m256d one = _mm256_set1_pd(1);
+
+    __m128i at = _mm_loadu_si128((const __m128i*)&batch.start[set]);
+    __m128i left = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)&batch.start[set + 1]), at);
+    __m128i step = _mm_set1_epi32(1);
+    uint32_t longest = longestSet(batch, set, 4);
+    for (uint32_t k = 0; k < longest; k++)
+    {
+        __m128i live = _mm_cmpgt_epi32(left, _mm_setzero_si128());
+        __m128i c = _mm_mask_i32gather_epi32(_mm_setzero_si128(), (const int*)batch.wcet.data(), at, live, 4);
+        __m128i t = _mm_mask_i32gather_epi32(step, (const int*)batch.period.data(), at, live, 4);
+        __m256d u = _mm256_div_pd(_mm256_cvtepi32_pd(c), _mm256_cvtepi32_pd(t));
+        sum = _mm256_add_pd(sum, u);
+        product = _mm256_mul_pd(product, _mm256_add_pd(u, one));
+        at = _mm_add_epi32(at, step);
+        left = _mm_sub_epi32(left, step);
+    }
+
+    _mm256_storeu_pd(utilization + set, sum);
+    _mm256_storeu_pd(hyperbolic + set, product);
+}
+
+#endif
+
+// what KERNEL_BEST means on this machine
+inline BoundKernel bestKernel()
+{
+#ifdef BATCH_BOUNDS_X86
+    return __builtin_cpu_supports("avx2") ? KERNEL_AVX2 : KERNEL_SSE2;
+#else
+    return KERNEL_SCALAR;
+#endif
+}
+
+// liu-layland bound for every task count up to n, liuLaylandBound without the pow per set
+inline void liuLaylandTable(size_t n, std::vector<double>& bounds)
+{
+    bounds.resize(n + 1);
+    bounds[0] = 1; // nothing to schedule
+    for (size_t k = 1; k <= n; k++)
+    {
+        bounds[k] = k * (std::pow(2.0, 1.0 / k) - 1);
+    }
+}
+
+// utilization, hyperbolic product and verdict of every set in the batch. a kernel the cpu can't
+// run falls back to the next one down
+inline void evaluateBounds(const TaskSetBatch& batch, BoundResults& results, BoundKernel kernel = KERNEL_BEST)
+{
+    if (kernel == KERNEL_BEST)
+    {
+        kernel = bestKernel();
+    }
+#ifdef BATCH_BOUNDS_X86
+    if (kernel == KERNEL_AVX2 && !__builtin_cpu_supports("avx2"))
+    {
+        kernel = KERNEL_SSE2;
+    }
+#else
+    kernel = KERNEL_SCALAR;
+#endif
+
+    size_t sets = batch.size();
+    results.utilization.resize(sets);
+    results.hyperbolic.resize(sets);
+    results.verdict.resize(sets);
+    for (int v = 0; v < VERDICT_COUNT; v++)
+    {
+        results.counts[v] = 0;
+    }
+
+    size_t largest = 0;
+    for (size_t i = 0; i < sets; i++)
+    {
+        size_t n = batch.start[i + 1] - batch.start[i];
+        largest = n > largest ? n : largest;
+    }
+    std::vector<double> bounds;
+    liuLaylandTable(largest, bounds);
+
+    // whole groups of sets go through the vector kernel, what is left over one set at a time
+    double* utilization = results.utilization.data();
+    double* hyperbolic = results.hyperbolic.data();
+    size_t set = 0;
+#ifdef BATCH_BOUNDS_X86
+    if (kernel == KERNEL_AVX2 && batch.wcet.size() <= (size_t)INT32_MAX)
+    {
+        for (; set + 4 <= sets; set += 4)
+        {
+            avx2Sets(batch, set, utilization, hyperbolic);
+        }
+    }
+    else if (kernel != KERNEL_SCALAR)
+    {
+        for (; set + 2 <= sets; set += 2)
+        {
+            sse2Sets(batch, set, utilization, hyperbolic);
+        }
+    }
+#endif
+    for (; set < sets; set++)
+    {
+        scalarSet(batch, set, utilization[set], hyperbolic[set]);
+    }
+
+    for (size_t i = 0; i < sets; i++)
+    {
+        double u = utilization[i], h = hyperbolic[i];
+        uint8_t verdict;
+        if (!(u <= 1)) // a zero period makes it nan or inf, both are out
+        {
+            verdict = OVERLOADED;
+        }
+        else if (u <= bounds[batch.start[i + 1] - batch.start[i]])
+        {
+            verdict = LIU_LAYLAND;
+        }
+        else if (h <= 2)
+        {
+            verdict = HYPERBOLIC;
+        }
+        else
+        {
+            verdict = NEEDS_EXACT;
+        }
+
+        results.verdict[i] = verdict;
+        results.counts[verdict]++;
+    }
+}
+
+// the set numbers sorted by verdict (a counting sort, stable within a verdict), first[v] is where
+// verdict v starts in order
+inline void groupByVerdict(const BoundResults& results, std::vector<uint32_t>& order, size_t (&first)[VERDICT_COUNT + 1])
+{
+    first[0] = 0;
+    for (int v = 0; v < VERDICT_COUNT; v++)
+    {
+        first[v + 1] = first[v] + results.counts[v];
+    }
+
+    size_t next[VERDICT_COUNT];
+    for (int v = 0; v < VERDICT_COUNT; v++)
+    {
+        next[v] = first[v];
+    }
+    order.resize(results.verdict.size());
+    for (size_t i = 0; i < results.verdict.size(); i++)
+    {
+        order[next[results.verdict[i]]++] = (uint32_t)i;
+    }
+}
+
+#endif
@@ -0,0 +1,490 @@
+// benchmark for the scheduler engines. it generates random task sets (UUniFast utilizations,
+// log-uniform periods) and runs every engine over the same sets, then prints one JSON line per
+// engine with its throughput in sets/s, and in simulated time units (ticks) per second for the
+// engines that simulate or tasks per second for the ones that only decide.
+//
+//   g++ -std=c++17 -O2 -pthread Benchmark.cpp librms.cpp -o benchmark
+//   ./benchmark --sets 2000 --tasks 8 --util 0.8 --hyperperiod-limit 100000 --repeat 3
+//   ./benchmark --cores 4 --util 2.5                (the global and partitioning engines on 4 cores)
+//   ./benchmark --generate --sets 100 > sets.txt    (the same kind of sets as input for PA3 / PA3-OS)
+//   ./benchmark --bounds-only --sets 1000000        (just the batch bound kernels)
+//
+// RMSA-cached runs RMSA with a result cache that holds every set and is filled before the clock
+// starts, so it measures what a hit costs. its line carries the cache counters of the timed runs,
+// a hit rate under 1 means it measured misses instead
+//
+// every engine runs on one thread so the numbers don't depend on the machine's core count. the
+// global engines simulate --cores cores and the partitioning ones pack onto --cores CPUs, all of
+// them in the calling thread
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <numeric>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "Scheduler.h"
+#include "WorkStealing.h"
+#include "Pipeline.h"
+#include "Input.h"
+#include "Format.h"
+#include "Generator.h"
+#include "BatchBounds.h"
+#include "TaskTable.h"
+#include "ResultCache.h"
+#include "Admission.h"
+#include "Partition.h"
+#include "GlobalSchedule.h"
+#include "Edf.h"
+#include "Analysis.h"
+#include "Server.h"
+#include "Binary.h"
+#include "Report.h"
+#include "Rmsa.h"
+#include "Rms.h"
+#include "librms.h"
+
+// one generated set, as the programs read it and as the simulators see it
+struct BenchSet
+{
+    std::string line;
+    std::vector<GeneratedTask> tasks; // input order
+    std::vector<SimTask> ranked;      // rate monotonic order
+    std::vector<EdfTask> edf;         // ranked, every task due at its next release
+    // how much of the timeline each kind of engine simulates, 0 if it never gets that far
+    long long ticks;       // rate monotonic on one cpu
+    long long edfTicks;    // EDF on one cpu
+    long long globalTicks; // global rate monotonic or EDF on --cores cores
+};
+
+// --cores: cores for the global engines, CPUs for the partitioning ones
+int benchCores = 2;
+
+// reports end up here, it is never started so nothing is printed
+OrderedWriter sink(IN_FLIGHT);
+long long reportNum = 0;
+
+// no size limit, the default one is smaller than the schedules of a default run and would evict
+// every set before it comes round again
+ResultCache cache(std::numeric_limits<size_t>::max(), true);
+
+// PA3's job for set, rate monotonic on one cpu and no cache
+args benchJob(const BenchSet& set, long long windowLimit)
+{
+    args job;
+    job.in.text = set.line;
+    job.num = (int)++reportNum;
+    job.cpu = job.num;
+    job.cores = 0;
+    job.algorithm = RATE_MONOTONIC;
+    job.binaryIn = false;
+    job.binaryOut = false;
+    job.windowLimit = windowLimit;
+    job.writer = &sink;
+    job.pool = NULL; // no splitting, one thread
+    job.cache = NULL;
+    return job;
+}
+
+void runPA3(const BenchSet& set, long long windowLimit)
+{
+    args job = benchJob(set, windowLimit);
+    RMSA(&job);
+}
+
+void runPA3Cached(const BenchSet& set, long long windowLimit)
+{
+    args job = benchJob(set, windowLimit);
+    job.cache = &cache;
+    RMSA(&job);
+}
+
+void runEDFA(const BenchSet& set, long long windowLimit)
+{
+    args job = benchJob(set, windowLimit);
+    job.algorithm = EARLIEST_DEADLINE_FIRST;
+    EDFA(&job);
+}
+
+void runGlobal(const BenchSet& set, long long windowLimit, Algorithm algorithm)
+{
+    args job = benchJob(set, windowLimit);
+    job.cores = benchCores;
+    job.algorithm = algorithm;
+    globalRMSA(&job);
+}
+
+void runGlobalRM(const BenchSet& set, long long windowLimit)
+{
+    runGlobal(set, windowLimit, RATE_MONOTONIC);
+}
+
+void runGlobalEDF(const BenchSet& set, long long windowLimit)
+{
+    runGlobal(set, windowLimit, EARLIEST_DEADLINE_FIRST);
+}
+
+void runOS(const BenchSet& set, long long windowLimit)
+{
+    Info info;
+    info.line.text = set.line;
+    info.windowLimit = windowLimit;
+    info.binary = false;
+    info.binaryOut = false;
+    info.algorithm = RATE_MONOTONIC;
+    info.CPUnum = (int)++reportNum;
+    readSet(&info);
+
+    ReportBuffer& report = workerBuffer();
+    report.clear();
+    info.report = &report;
+    RMS(&info);
+    sink.deliver(info.CPUnum, report.text);
+}
+
+// the bare event driven simulator, no parsing and no formatting
+long long segmentsSeen = 0;
+
+void runSimulator(const BenchSet& set, long long)
+{
+    if (set.ticks > 0)
+    {
+        simulateRMS(set.ranked, set.ticks, [&](int, long long, long long) { segmentsSeen++; });
+    }
+}
+
+// the engines below only decide, what they decide is counted so none of it gets optimized away
+long long decided = 0;
+
+// the bare QPA test
+void runQPA(const BenchSet& set, long long)
+{
+    decided += quickProcessorDemand(set.edf).schedulable;
+}
+
+// a runtime admitting the set's tasks one at a time
+void runAdmission(const BenchSet& set, long long)
+{
+    AdmissionAnalyzer cpu;
+    for (size_t k = 0; k < set.tasks.size(); k++)
+    {
+        decided += cpu.admit(set.tasks[k].name, set.tasks[k].wcet, set.tasks[k].period).verdict == ADMIT_OK;
+    }
+}
+
+// the set as a pool packed onto --cores CPUs, without the per CPU analysis --partition runs after
+void runPartitioning(const BenchSet& set, FitHeuristic fit)
+{
+    std::vector<PartitionTask> tasks;
+    for (size_t k = 0; k < set.tasks.size(); k++)
+    {
+        tasks.push_back({ set.tasks[k].name, set.tasks[k].wcet, set.tasks[k].period });
+    }
+    Partition partition;
+    partitionTasks(tasks, benchCores, fit, NULL, partition);
+    decided += std::count(partition.cpuOf.begin(), partition.cpuOf.end(), -1);
+}
+
+void runFirstFit(const BenchSet& set, long long)
+{
+    runPartitioning(set, FIRST_FIT);
+}
+
+void runBestFit(const BenchSet& set, long long)
+{
+    runPartitioning(set, BEST_FIT);
+}
+
+// librms the way a program embedding it would use it: parse the line, analyze it, free the result
+void runLibrary(const BenchSet& set, long long windowLimit)
+{
+    std::vector<rms_task> tasks(set.tasks.size());
+    size_t count = rms_parse(set.line.data(), set.line.size(), tasks.data(), tasks.size());
+    rms_result* result;
+    if (rms_analyze(tasks.data(), count, windowLimit, 0, &result) == RMS_OK)
+    {
+        decided += rms_result_schedulable(result);
+        rms_result_free(result);
+    }
+}
+
+struct Engine
+{
+    const char* name;
+    void (*run)(const BenchSet&, long long);
+    ResultCache* cache;        // filled by an untimed run first, NULL for an engine without one
+    long long BenchSet::*ticks; // the timeline it simulates, NULL for one that only decides
+};
+
+const Engine engines[] = {
+    { "RMSA", runPA3, NULL, &BenchSet::ticks },
+    { "RMSA-cached", runPA3Cached, &cache, &BenchSet::ticks },
+    { "RMS", runOS, NULL, &BenchSet::ticks },
+    { "simulateRMS", runSimulator, NULL, &BenchSet::ticks },
+    { "rms_analyze", runLibrary, NULL, &BenchSet::ticks },
+    { "EDFA", runEDFA, NULL, &BenchSet::edfTicks },
+    { "quickProcessorDemand", runQPA, NULL, NULL },
+    { "globalRMSA-rm", runGlobalRM, NULL, &BenchSet::globalTicks },
+    { "globalRMSA-edf", runGlobalEDF, NULL, &BenchSet::globalTicks },
+    { "admission", runAdmission, NULL, NULL },
+    { "partition-first-fit", runFirstFit, NULL, NULL },
+    { "partition-best-fit", runBestFit, NULL, NULL },
+};
+
+struct BoundEngine
+{
+    const char* name;
+    BoundKernel kernel;
+};
+
+const BoundEngine boundEngines[] = {
+    { "bounds-scalar", KERNEL_SCALAR },
+    { "bounds-sse2", KERNEL_SSE2 },
+    { "bounds-avx2", KERNEL_AVX2 },
+};
+
+// the fastest of repeat runs of work, the others only had more noise in them
+template <typename Work>
+double fastest(int repeat, Work work)
+{
+    double best = 0;
+    for (int r = 0; r < repeat; r++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        work();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || seconds < best)
+        {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+// the fields every result line starts with
+void resultHeader(ReportBuffer& json, const char* engine, size_t sets, const GeneratorSettings& settings, unsigned long long seed, double seconds)
+{
+    json << "{\"engine\": \"" << engine << "\", \"sets\": " << (long long)sets
+         << ", \"tasks\": " << settings.tasks << ", \"utilization\": " << Fixed{ settings.utilization, 3 }
+         << ", \"hyperperiod_limit\": " << settings.hyperperiodLimit << ", \"seed\": " << seed
+         << ", \"seconds\": " << Fixed{ seconds, 6 }
+         << ", \"sets_per_s\": " << Fixed{ seconds > 0 ? sets / seconds : 0, 1 };
+}
+
+// ranks the set like both programs do and works out how much of it each engine simulates: nothing
+// if its test turns the set down, else the window it draws
+BenchSet prepare(const std::vector<GeneratedTask>& tasks, long long windowLimit)
+{
+    BenchSet set;
+    set.line = formatSet(tasks);
+    set.tasks = tasks;
+
+    std::vector<GeneratedTask> ranked = tasks;
+    std::stable_sort(ranked.begin(), ranked.end(), [](const GeneratedTask& a, const GeneratedTask& b)
+    {
+        return a.period == b.period ? a.name < b.name : a.period < b.period;
+    });
+
+    double util = 0;
+    long long hyperPeriod = 1;
+    for (size_t k = 0; k < ranked.size(); k++)
+    {
+        set.ranked.push_back({ ranked[k].wcet, ranked[k].period });
+        set.edf.push_back({ ranked[k].wcet, ranked[k].period, ranked[k].period });
+        util += (double)ranked[k].wcet / ranked[k].period;
+        hyperPeriod = checkedLcm(hyperPeriod, ranked[k].period);
+    }
+
+    std::vector<long long> responses;
+    set.ticks = 0;
+    if (util <= 1 && responseTimeAnalysis(set.ranked, responses))
+    {
+        set.ticks = simulationWindow(set.ranked, hyperPeriod, windowLimit);
+    }
+    set.edfTicks = quickProcessorDemand(set.edf).schedulable ? simulationWindow(set.ranked, hyperPeriod, windowLimit) : 0;
+    set.globalTicks = 0;
+    if (util <= benchCores)
+    {
+        set.globalTicks = hyperPeriod != HYPERPERIOD_OVERFLOW && hyperPeriod <= windowLimit ? hyperPeriod : windowLimit;
+    }
+    return set;
+}
+
+int main(int argc, char* argv[])
+{
+    GeneratorSettings settings = { 8, 0.8, 10, 1000, 10, 100000, 100 };
+    long long sets = 1000;
+    long long windowLimit = DEFAULT_WINDOW_LIMIT;
+    unsigned long long seed = 1;
+    int repeat = 3;
+    bool generate = false;
+    bool boundsOnly = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--generate")
+        {
+            generate = true;
+        }
+        else if (option == "--bounds-only")
+        {
+            boundsOnly = true;
+        }
+        else if (option == "--sets" && hasValue)
+        {
+            sets = std::atoll(argv[++i]);
+        }
+        else if (option == "--tasks" && hasValue)
+        {
+            settings.tasks = std::atoi(argv[++i]);
+        }
+        else if (option == "--util" && hasValue)
+        {
+            settings.utilization = std::atof(argv[++i]);
+        }
+        else if (option == "--period-min" && hasValue)
+        {
+            settings.periodMin = std::atoll(argv[++i]);
+        }
+        else if (option == "--period-max" && hasValue)
+        {
+            settings.periodMax = std::atoll(argv[++i]);
+        }
+        else if (option == "--granularity" && hasValue)
+        {
+            settings.granularity = std::atoll(argv[++i]);
+        }
+        else if (option == "--hyperperiod-limit" && hasValue)
+        {
+            settings.hyperperiodLimit = std::atoll(argv[++i]);
+        }
+        else if (option == "--window-limit" && hasValue)
+        {
+            windowLimit = std::atoll(argv[++i]);
+        }
+        else if (option == "--seed" && hasValue)
+        {
+            seed = std::strtoull(argv[++i], NULL, 10);
+        }
+        else if (option == "--repeat" && hasValue)
+        {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (option == "--cores" && hasValue)
+        {
+            benchCores = std::max(1, std::min(MAX_GLOBAL_CORES, std::atoi(argv[++i])));
+        }
+        else
+        {
+            std::cerr << "unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    if (settings.tasks < 1 || settings.periodMin < 1 || settings.periodMax < settings.periodMin)
+    {
+        std::cerr << "need --tasks >= 1 and 1 <= --period-min <= --period-max" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<BenchSet> input;
+    TaskSetBatch batch;
+    for (long long i = 0; i < sets; i++)
+    {
+        std::vector<GeneratedTask> tasks = generateSet(settings, rng);
+        if (generate)
+        {
+            std::cout << formatSet(tasks) << "\n";
+            continue;
+        }
+        for (size_t k = 0; k < tasks.size(); k++)
+        {
+            batch.addTask((int32_t)tasks[k].wcet, (int32_t)tasks[k].period);
+        }
+        batch.endSet();
+        if (!boundsOnly)
+        {
+            input.push_back(prepare(tasks, windowLimit));
+        }
+    }
+    if (generate)
+    {
+        return 0;
+    }
+
+    for (const Engine& engine : engines)
+    {
+        if (boundsOnly)
+        {
+            break;
+        }
+        auto runAll = [&]()
+        {
+            for (size_t i = 0; i < input.size(); i++)
+            {
+                engine.run(input[i], windowLimit);
+            }
+        };
+        if (engine.cache)
+        {
+            runAll();
+            engine.cache->hits = engine.cache->misses = engine.cache->evictions = 0;
+        }
+        double best = fastest(repeat, runAll);
+
+        ReportBuffer json;
+        resultHeader(json, engine.name, input.size(), settings, seed, best);
+        if (engine.ticks)
+        {
+            long long ticks = 0;
+            for (size_t i = 0; i < input.size(); i++)
+            {
+                ticks += input[i].*engine.ticks;
+            }
+            json << ", \"ticks\": " << ticks << ", \"ticks_per_s\": " << Fixed{ best > 0 ? ticks / best : 0, 1 };
+        }
+        else
+        {
+            json << ", \"tasks_per_s\": " << Fixed{ best > 0 ? batch.wcet.size() / best : 0, 1 };
+        }
+        if (engine.cache)
+        {
+            long long lookups = engine.cache->hits + engine.cache->misses;
+            json << ", \"cache_hits\": " << engine.cache->hits << ", \"cache_misses\": " << engine.cache->misses
+                 << ", \"cache_evictions\": " << engine.cache->evictions << ", \"cache_bytes\": " << (long long)engine.cache->usedBytes
+                 << ", \"hit_rate\": " << Fixed{ lookups > 0 ? (double)engine.cache->hits / lookups : 0, 3 };
+        }
+        json << "}\n";
+        std::cout << json.text;
+    }
+
+    // the batch kernels only give verdicts, so they are counted in sets and in tasks
+    BoundResults results;
+    for (const BoundEngine& engine : boundEngines)
+    {
+        double best = fastest(repeat, [&]() { evaluateBounds(batch, results, engine.kernel); });
+
+        ReportBuffer json;
+        resultHeader(json, engine.name, batch.size(), settings, seed, best);
+        json << ", \"tasks_per_s\": " << Fixed{ best > 0 ? batch.wcet.size() / best : 0, 1 }
+             << ", \"overloaded\": " << results.counts[OVERLOADED] << ", \"liu_layland\": " << results.counts[LIU_LAYLAND]
+             << ", \"hyperbolic\": " << results.counts[HYPERBOLIC] << ", \"needs_exact\": " << results.counts[NEEDS_EXACT] << "}\n";
+        std::cout << json.text;
+    }
+    std::cout.flush();
+
+    return 0;
+}
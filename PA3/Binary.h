@@ -0,0 +1,273 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Input.h"
+#include "Scheduler.h"
+
+// the binary formats, for batches big enough that parsing and printing text is most of the work.
+// every number is little endian and fixed width, a file starts with an 8 byte magic.
+//
+// sets (--input-format binary), SET_MAGIC then one record per set:
+//   u32 task count
+//   per task: u16 name length, the name, i32 wcet, i32 period. the set ends at the first task
+//   with an empty name, the way a text line ends at the first field that doesn't fit
+//
+// results (--output-format binary), RESULT_MAGIC then one record per set:
+//   u32 length of the rest of the record
+//   u32 cpu, u8 verdict (RESULT_*), f64 utilization, i64 hyperperiod (-1 past 64 bits),
+//   i64 window (how much of the timeline the schedule covers, 0 if there is none)
+//   u32 task count
+//   per task, in the order given: u16 name length, the name, i32 wcet, i32 period,
+//     u32 rank (its place in rate monotonic order), i64 response (-1 if the test didn't run)
+//   u32 segment count
+//   per segment: i32 task (rank, -1 for idle), i64 length. they follow each other from 0
+//
+// Convert.cpp turns sets from text to binary and back, and results into the text PA3 prints
+
+const std::string_view SET_MAGIC("PA3SETS1", 8);
+const std::string_view RESULT_MAGIC("PA3RSLT1", 8);
+
+// the verdict in a result record
+enum ResultVerdict
+{
+    RESULT_UNDER_BOUND = 0, // utilization at most the liu-layland bound
+    RESULT_EXACT_MET = 1,   // over the bound, every response time within its period
+    RESULT_EXACT_MISSED = 2,
+    RESULT_OVERLOADED = 3   // utilization over 1
+};
+
+// the longest name a record can hold, longer ones are cut off
+const size_t MAX_BINARY_NAME = 0xffff;
+
+template <typename Unsigned>
+inline void putUnsigned(std::string& out, Unsigned value)
+{
+    char bytes[sizeof(Unsigned)];
+    for (size_t i = 0; i < sizeof(Unsigned); i++)
+    {
+        bytes[i] = (char)(value >> (8 * i));
+    }
+    out.append(bytes, sizeof(Unsigned));
+}
+
+inline void putU8(std::string& out, uint8_t value) { out += (char)value; }
+inline void putU16(std::string& out, uint16_t value) { putUnsigned(out, value); }
+inline void putU32(std::string& out, uint32_t value) { putUnsigned(out, value); }
+inline void putI32(std::string& out, int32_t value) { putUnsigned(out, (uint32_t)value); }
+inline void putI64(std::string& out, int64_t value) { putUnsigned(out, (uint64_t)value); }
+
+inline void putF64(std::string& out, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putUnsigned(out, bits);
+}
+
+inline void putName(std::string& out, std::string_view name)
+{
+    size_t length = name.size() < MAX_BINARY_NAME ? name.size() : MAX_BINARY_NAME;
+    putU16(out, (uint16_t)length);
+    out.append(name.data(), length);
+}
+
+// overwrites the u32 at offset, for a length that is only known once the record is done
+inline void patchU32(std::string& out, size_t offset, uint32_t value)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        out[offset + i] = (char)(value >> (8 * i));
+    }
+}
+
+// reads the fields of a record in place. a read past the end fails and every read after it too
+struct BinaryCursor
+{
+    const char* pos;
+    const char* end;
+
+    BinaryCursor(std::string_view bytes) : pos(bytes.data()), end(bytes.data() + bytes.size()) {}
+
+    template <typename Unsigned>
+    bool getUnsigned(Unsigned& value)
+    {
+        if ((size_t)(end - pos) < sizeof(Unsigned))
+        {
+            pos = end;
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < sizeof(Unsigned); i++)
+        {
+            value |= (Unsigned)(unsigned char)pos[i] << (8 * i);
+        }
+        pos += sizeof(Unsigned);
+        return true;
+    }
+
+    bool u8(uint8_t& value) { return getUnsigned(value); }
+    bool u16(uint16_t& value) { return getUnsigned(value); }
+    bool u32(uint32_t& value) { return getUnsigned(value); }
+
+    bool i32(int32_t& value)
+    {
+        uint32_t bits;
+        if (!getUnsigned(bits))
+        {
+            return false;
+        }
+        value = (int32_t)bits;
+        return true;
+    }
+
+    bool i64(int64_t& value)
+    {
+        uint64_t bits;
+        if (!getUnsigned(bits))
+        {
+            return false;
+        }
+        value = (int64_t)bits;
+        return true;
+    }
+
+    bool f64(double& value)
+    {
+        uint64_t bits;
+        if (!getUnsigned(bits))
+        {
+            return false;
+        }
+        memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool name(std::string_view& value)
+    {
+        uint16_t length;
+        if (!u16(length) || (size_t)(end - pos) < length)
+        {
+            pos = end;
+            return false;
+        }
+        value = std::string_view(pos, length);
+        pos += length;
+        return true;
+    }
+};
+
+// the verdict of a set as the text report would tell it
+inline uint8_t resultVerdict(bool overloaded, bool needsExact, bool schedulable)
+{
+    return overloaded ? RESULT_OVERLOADED : !needsExact ? RESULT_UNDER_BOUND : schedulable ? RESULT_EXACT_MET : RESULT_EXACT_MISSED;
+}
+
+// starts a result record, up to the task count, and returns where it starts. every task goes in
+// with putResultTask after it, then finishResult adds the segments and fills in the length
+inline size_t startResult(std::string& out, int cpu, uint8_t verdict, double util, long long hyperPeriod, long long window, size_t count)
+{
+    size_t start = out.size();
+    putU32(out, 0);
+    putU32(out, (uint32_t)cpu);
+    putU8(out, verdict);
+    putF64(out, util);
+    putI64(out, hyperPeriod);
+    putI64(out, window);
+    putU32(out, (uint32_t)count);
+    return start;
+}
+
+inline void putResultTask(std::string& out, std::string_view name, int wcet, int period, uint32_t rank, long long response)
+{
+    putName(out, name);
+    putI32(out, wcet);
+    putI32(out, period);
+    putU32(out, rank);
+    putI64(out, response);
+}
+
+inline void finishResult(std::string& out, size_t start, const std::vector<Segment>& segments)
+{
+    putU32(out, (uint32_t)segments.size());
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        putI32(out, segments[i].task);
+        putI64(out, segments[i].length);
+    }
+    patchU32(out, start, (uint32_t)(out.size() - start - 4));
+}
+
+// where the set record starting at pos ends, NULL if it isn't all there before end
+inline const char* setRecordEnd(const char* pos, const char* end)
+{
+    BinaryCursor record(std::string_view(pos, end - pos));
+    uint32_t count;
+    if (!record.u32(count))
+    {
+        return NULL;
+    }
+    for (uint32_t k = 0; k < count; k++)
+    {
+        uint16_t length;
+        if (!record.u16(length) || (size_t)(record.end - record.pos) < length + 8u)
+        {
+            return NULL;
+        }
+        record.pos += length + 8;
+    }
+    return record.pos;
+}
+
+// where the result record starting at pos ends, NULL if it isn't all there before end
+inline const char* resultRecordEnd(const char* pos, const char* end)
+{
+    BinaryCursor record(std::string_view(pos, end - pos));
+    uint32_t length;
+    if (!record.u32(length) || (size_t)(record.end - record.pos) < length)
+    {
+        return NULL;
+    }
+    return record.pos + length;
+}
+
+// the tasks of one set, from a text line or a binary set record
+struct TaskCursor
+{
+    FieldCursor fields;
+    BinaryCursor record;
+    bool binary;
+    uint32_t left; // tasks still in the record
+
+    TaskCursor(std::string_view set, bool binaryRecord) : fields(set), record(set), binary(binaryRecord), left(0)
+    {
+        if (binary && !record.u32(left))
+        {
+            left = 0;
+        }
+    }
+
+    bool next(std::string_view& name, int& wcet, int& period)
+    {
+        if (!binary)
+        {
+            return fields.word(name) && fields.integer(wcet) && fields.integer(period);
+        }
+
+        // a name can't be empty in the text format, and the diagram has nothing to draw it with
+        int32_t w, p;
+        if (left == 0 || !record.name(name) || name.empty() || !record.i32(w) || !record.i32(p))
+        {
+            return false;
+        }
+        left--;
+        wcet = w;
+        period = p;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,228 @@
+// converter for the binary formats of Binary.h. what it does depends on what it is given:
+//   binary task sets  ->  the same sets as text input lines
+//   binary results    ->  the text report PA3 prints for them, byte for byte
+//   text input        ->  binary task sets
+//
+//   g++ -std=c++17 -O2 Convert.cpp -o convert
+//   ./convert < sets.txt > sets.bin
+//   ./PA3 --input-format binary --output-format binary < sets.bin > results.bin
+//   ./convert < results.bin > results.txt    (the same as ./PA3 < sets.txt)
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Scheduler.h"
+#include "Input.h"
+#include "Format.h"
+#include "Binary.h"
+#include "Report.h"
+
+// output goes out in pieces about this big
+const size_t WRITE_CHUNK = 1 << 20;
+
+void flushOut(std::string& out, bool force)
+{
+    if (force || out.size() >= WRITE_CHUNK)
+    {
+        fwrite(out.data(), 1, out.size(), stdout);
+        out.clear();
+    }
+}
+
+// a task of a result record
+struct ResultTask
+{
+    std::string_view name;
+    int32_t wcet;
+    int32_t period;
+    uint32_t rank;
+    int64_t response;
+};
+
+// one result record back into the text report, false if it is cut short or doesn't add up
+bool resultToText(std::string_view record, ReportBuffer& out)
+{
+    BinaryCursor fields(record);
+    uint32_t length, cpu, count, segmentCount;
+    uint8_t verdict;
+    double util;
+    int64_t hyperPeriod, window;
+    if (!fields.u32(length) || !fields.u32(cpu) || !fields.u8(verdict) || !fields.f64(util) || !fields.i64(hyperPeriod)
+        || !fields.i64(window) || !fields.u32(count))
+    {
+        return false;
+    }
+
+    std::vector<ResultTask> tasks(count);
+    std::vector<uint32_t> ranked(count, count); // ranked[r] is the task with rank r
+    std::vector<long long> responses(count);
+    for (uint32_t k = 0; k < count; k++)
+    {
+        ResultTask& task = tasks[k];
+        if (!fields.name(task.name) || !fields.i32(task.wcet) || !fields.i32(task.period) || !fields.u32(task.rank) || !fields.i64(task.response)
+            || task.rank >= count || ranked[task.rank] != count)
+        {
+            return false;
+        }
+        ranked[task.rank] = k;
+        responses[task.rank] = task.response;
+    }
+
+    std::vector<Segment> segments;
+    long long start = 0;
+    if (!fields.u32(segmentCount))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < segmentCount; i++)
+    {
+        int32_t task;
+        int64_t run;
+        if (!fields.i32(task) || !fields.i64(run) || task < IDLE || task >= (int32_t)count)
+        {
+            return false;
+        }
+        segments.push_back({ task, start, run });
+        start += run;
+    }
+
+    auto taskAt = [&](size_t k) { return ReportTask{ tasks[k].name, tasks[k].wcet, tasks[k].period }; };
+    auto rankedAt = [&](size_t r) { return taskAt(ranked[r]); };
+
+    writeSetInfo(out, (int)cpu, count, taskAt, util, hyperPeriod);
+    out << "Rate Monotonic Algorithm execution for CPU " << (int)cpu << ":\n";
+    if (verdict == RESULT_OVERLOADED)
+    {
+        out << "The task set is not schedulable\n";
+    }
+    else if (verdict == RESULT_EXACT_MET || verdict == RESULT_EXACT_MISSED)
+    {
+        writeResponses(out, count, rankedAt, responses);
+        if (verdict == RESULT_EXACT_MISSED)
+        {
+            out << "The task set is not schedulable\n";
+        }
+    }
+
+    if (verdict == RESULT_UNDER_BOUND || verdict == RESULT_EXACT_MET)
+    {
+        writeDiagramHead(out, (int)cpu, window, hyperPeriod);
+        writeDiagram(out, segments, [&](int r) { return tasks[ranked[r]].name; });
+    }
+    out << "\n\n";
+    return true;
+}
+
+// one binary set back into an input line
+void setToText(std::string_view record, ReportBuffer& out)
+{
+    TaskCursor fields(record, true);
+    std::string_view name;
+    int wcet, period;
+    const char* separator = "";
+    while (fields.next(name, wcet, period))
+    {
+        out << separator << name << ' ' << wcet << ' ' << period;
+        separator = " ";
+    }
+    out << "\n";
+}
+
+// one input line as a binary set, false if a name is too long for the format
+bool textToSet(std::string_view line, std::string& out)
+{
+    size_t countAt = out.size();
+    putU32(out, 0);
+
+    TaskCursor fields(line, false);
+    std::string_view name;
+    int wcet, period;
+    uint32_t count = 0;
+    while (fields.next(name, wcet, period))
+    {
+        if (name.size() > MAX_BINARY_NAME)
+        {
+            return false;
+        }
+        putName(out, name);
+        putI32(out, wcet);
+        putI32(out, period);
+        count++;
+    }
+    patchU32(out, countAt, count);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    // --input FILE: read FILE instead of stdin
+    const char* inputPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--input" && i + 1 < argc)
+        {
+            inputPath = argv[++i];
+        }
+    }
+
+    LineReader reader;
+    if (!reader.open(inputPath))
+    {
+        std::cerr << "Error opening " << inputPath << std::endl;
+        return 1;
+    }
+
+    ReportBuffer out;
+    InputLine record;
+    size_t count = 0;
+    if (reader.skip(SET_MAGIC))
+    {
+        reader.recordEnd = setRecordEnd;
+        while (reader.next(record))
+        {
+            count++;
+            setToText(record.text, out);
+            flushOut(out.text, false);
+        }
+    }
+    else if (reader.skip(RESULT_MAGIC))
+    {
+        reader.recordEnd = resultRecordEnd;
+        while (reader.next(record))
+        {
+            count++;
+            if (!resultToText(record.text, out))
+            {
+                flushOut(out.text, true);
+                std::cerr << "Result " << count << " is damaged" << std::endl;
+                return 1;
+            }
+            flushOut(out.text, false);
+        }
+    }
+    else
+    {
+        out.text.append(SET_MAGIC.data(), SET_MAGIC.size());
+        while (reader.next(record) && record.text != "exit")
+        {
+            count++;
+            if (!textToSet(record.text, out.text))
+            {
+                flushOut(out.text, true);
+                std::cerr << "Line " << count << " has a name longer than " << MAX_BINARY_NAME << " bytes" << std::endl;
+                return 1;
+            }
+            flushOut(out.text, false);
+        }
+    }
+
+    flushOut(out.text, true);
+    if (reader.cutOff())
+    {
+        std::cerr << "The input ends partway through record " << count + 1 << std::endl;
+        return 1;
+    }
+    return 0;
+}
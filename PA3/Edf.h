@@ -0,0 +1,231 @@
+#ifndef EDF_H
+#define EDF_H
+
+#include <climits>
+#include <vector>
+#include "Scheduler.h"
+#include "GlobalSchedule.h"
+#include "Analysis.h"
+
+// earliest deadline first on one cpu: the exact schedulability test and the simulator.
+//
+// the test is Quick Processor-demand Analysis (Zhang and Burns, 2009). a set is schedulable under
+// EDF iff the demand h(t), the work of every job with release and deadline inside [0, t], is at most
+// t for every t. that only has to hold up to a bound L, and QPA walks down from L jumping straight
+// to h(t) whenever h(t) < t, so it looks at a handful of points instead of every deadline in
+// the hyperperiod. tasks can have deadlines shorter than their period; the programs give every
+// task its period as deadline, where the test comes down to the utilization being at most 1,
+// worked out exactly rather than in floating point
+
+// what --policy picks, in both programs: on one cpu, and in PA3 with --global too
+enum Algorithm
+{
+    RATE_MONOTONIC,
+    EARLIEST_DEADLINE_FIRST
+};
+
+// the policy the global simulator runs for algorithm
+inline GlobalPolicy globalPolicy(Algorithm algorithm)
+{
+    return algorithm == EARLIEST_DEADLINE_FIRST ? GLOBAL_EDF : GLOBAL_RM;
+}
+
+struct EdfTask
+{
+    long long wcet;
+    long long period;
+    long long deadline; // relative, at most the period
+};
+
+struct EdfAnalysis
+{
+    bool schedulable;
+    long long bound;  // L, the last point that had to be looked at (0 when the utilization decided it)
+    long long points; // how many times h(t) was worked out
+};
+
+// h(t), saturating at LLONG_MAX
+inline long long edfDemand(const std::vector<EdfTask>& tasks, long long t)
+{
+    long long demand = 0;
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (tasks[k].period <= 0 || tasks[k].wcet <= 0 || t < tasks[k].deadline)
+        {
+            continue;
+        }
+        long long work;
+        if (__builtin_mul_overflow((t - tasks[k].deadline) / tasks[k].period + 1, tasks[k].wcet, &work)
+            || __builtin_add_overflow(demand, work, &demand))
+        {
+            return LLONG_MAX;
+        }
+    }
+    return demand;
+}
+
+// the latest absolute deadline before t, 0 if there is none
+inline long long lastDeadlineBefore(const std::vector<EdfTask>& tasks, long long t)
+{
+    long long last = 0;
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (tasks[k].period <= 0 || tasks[k].wcet <= 0 || t <= tasks[k].deadline)
+        {
+            continue;
+        }
+        long long d = (t - 1 - tasks[k].deadline) / tasks[k].period * tasks[k].period + tasks[k].deadline;
+        last = d > last ? d : last;
+    }
+    return last;
+}
+
+// compares sum C / T with 1 exactly, as one fraction over the lcm of the periods, while that fits
+// in 62 bits; past that in long double. -1 under 1, 0 exactly 1, 1 over 1
+inline int compareUtilization(const std::vector<EdfTask>& tasks)
+{
+    __int128 numerator = 0;
+    long long denominator = 1;
+    long double sum = 0;
+    bool exact = true;
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (tasks[k].period <= 0 || tasks[k].wcet <= 0)
+        {
+            continue;
+        }
+        sum += (long double)tasks[k].wcet / tasks[k].period;
+
+        long long lcm = checkedLcm(denominator, tasks[k].period);
+        if (!exact || lcm == HYPERPERIOD_OVERFLOW || lcm > (1LL << 62))
+        {
+            exact = false;
+            continue;
+        }
+        numerator = numerator * (lcm / denominator) + (__int128)tasks[k].wcet * (lcm / tasks[k].period);
+        denominator = lcm;
+    }
+
+    if (exact)
+    {
+        return numerator < denominator ? -1 : numerator > denominator ? 1 : 0;
+    }
+    return sum < 1 ? -1 : sum > 1 ? 1 : 0;
+}
+
+// exact EDF test. a period of 0 or less, or no work, never asks for anything
+inline EdfAnalysis quickProcessorDemand(const std::vector<EdfTask>& tasks)
+{
+    EdfAnalysis result = { true, 0, 0 };
+    int utilization = compareUtilization(tasks);
+    if (utilization > 0)
+    {
+        result.schedulable = false;
+        return result;
+    }
+
+    long long deadlineMax = 0, deadlineMin = LLONG_MAX;
+    long double slack = 0; // sum of (T - D) U
+    bool implicit = true;
+    std::vector<SimTask> work;
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (tasks[k].period <= 0 || tasks[k].wcet <= 0)
+        {
+            continue;
+        }
+        deadlineMax = tasks[k].deadline > deadlineMax ? tasks[k].deadline : deadlineMax;
+        deadlineMin = tasks[k].deadline < deadlineMin ? tasks[k].deadline : deadlineMin;
+        slack += (long double)(tasks[k].period - tasks[k].deadline) * tasks[k].wcet / tasks[k].period;
+        implicit = implicit && tasks[k].deadline == tasks[k].period;
+        work.push_back({ tasks[k].wcet, tasks[k].period });
+    }
+    if (work.empty() || implicit)
+    {
+        return result; // h(t) <= U t <= t everywhere
+    }
+
+    // L is the smaller of the bound of la (only when U < 1) and the synchronous busy period, past
+    // which the cpu has been idle once and nothing new can go wrong
+    long long limit = LLONG_MAX / 4;
+    if (utilization < 0)
+    {
+        long double u = 0;
+        for (size_t k = 0; k < work.size(); k++)
+        {
+            u += (long double)work[k].wcet / work[k].period;
+        }
+        long double la = slack / (1 - u);
+        if (la < limit)
+        {
+            limit = (long long)la + 1;
+        }
+        limit = limit > deadlineMax ? limit : deadlineMax;
+    }
+    else
+    {
+        // exactly 1: the cpu never idles before the hyperperiod, which then is the bound
+        long long hyperPeriod = 1;
+        for (size_t k = 0; k < work.size(); k++)
+        {
+            hyperPeriod = checkedLcm(hyperPeriod, work[k].period);
+        }
+        if (hyperPeriod != HYPERPERIOD_OVERFLOW && hyperPeriod < limit)
+        {
+            limit = hyperPeriod;
+        }
+    }
+    result.bound = busyPeriod(work, limit);
+
+    long long t = lastDeadlineBefore(tasks, result.bound + 1);
+    long long demand = edfDemand(tasks, t);
+    result.points++;
+    while (demand <= t && demand > deadlineMin)
+    {
+        t = demand < t ? demand : lastDeadlineBefore(tasks, t);
+        demand = edfDemand(tasks, t);
+        result.points++;
+    }
+    result.schedulable = demand <= deadlineMin;
+    return result;
+}
+
+// EDF on one cpu over [0, to), emit(task, start, length) like simulateRMS. it is the global
+// simulator with a single core, so a job is kept apart from the next one of its task
+template <typename Emit>
+GlobalCounters simulateEDF(const std::vector<SimTask>& tasks, long long to, Emit emit)
+{
+    return simulateGlobal(tasks, 1, GLOBAL_EDF, to, [&](int, int task, long long start, long long length)
+    {
+        emit(task, start, length);
+    });
+}
+
+// decideSet for EDF: QPA with every task due at its next release, and the same window rate
+// monotonic gets, since the busy period is the same for any policy that never idles with work
+// waiting. there are no response times, responses stays empty
+inline void decideEdfSet(const std::vector<SimTask>& ranked, long long hyperPeriod, long long windowLimit, SetResult& result)
+{
+    std::vector<EdfTask> edfTasks;
+    for (size_t k = 0; k < ranked.size(); k++)
+    {
+        edfTasks.push_back({ ranked[k].wcet, ranked[k].period, ranked[k].period });
+    }
+
+    result.hyperPeriod = hyperPeriod;
+    result.schedulable = quickProcessorDemand(edfTasks).schedulable;
+    result.responses.clear();
+    result.segments.clear();
+    result.window = result.schedulable ? simulationWindow(ranked, hyperPeriod, windowLimit) : 0;
+}
+
+// the EDF schedule of a set decideEdfSet found schedulable, over its window
+inline void simulateEdfSet(const std::vector<SimTask>& ranked, SetResult& result)
+{
+    simulateEDF(ranked, result.window, [&](int task, long long start, long long length)
+    {
+        addSegment(result.segments, task, start, length);
+    });
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <charconv>
+#include <string>
+#include <string_view>
+
+// a number printed with a fixed number of decimals, what std::fixed << std::setprecision did
+struct Fixed
+{
+    double value;
+    int decimals;
+};
+
+// builds report text in place. numbers go through to_chars straight into the buffer, so there are
+// no temporaries, no streams and no locale. clear() keeps the memory, so a worker that reuses one
+// buffer for every report stops allocating once it has seen its biggest one
+struct ReportBuffer
+{
+    std::string text;
+
+    void clear()
+    {
+        text.clear();
+    }
+
+    ReportBuffer& operator<<(std::string_view s)
+    {
+        text.append(s.data(), s.size());
+        return *this;
+    }
+
+    ReportBuffer& operator<<(char c)
+    {
+        text += c;
+        return *this;
+    }
+
+    ReportBuffer& operator<<(int v) { return integer(v); }
+    ReportBuffer& operator<<(long v) { return integer(v); }
+    ReportBuffer& operator<<(long long v) { return integer(v); }
+    ReportBuffer& operator<<(unsigned v) { return integer(v); }
+    ReportBuffer& operator<<(unsigned long v) { return integer(v); }
+    ReportBuffer& operator<<(unsigned long long v) { return integer(v); }
+
+    ReportBuffer& operator<<(Fixed f)
+    {
+        char digits[400]; // enough for any double written out in full
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), f.value, std::chars_format::fixed, f.decimals);
+        text.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    template <typename Integer>
+    ReportBuffer& integer(Integer v)
+    {
+        char digits[24];
+        std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), v);
+        text.append(digits, result.ptr - digits);
+        return *this;
+    }
+};
+
+// the report buffer of the calling worker thread, reused from one report to the next
+inline ReportBuffer& workerBuffer()
+{
+    static thread_local ReportBuffer buffer;
+    return buffer;
+}
+
+// writes the diagram as runs, name(count) for a task and Idle(count) for the idle cpu. runs of the
+// same task that follow each other are glued into one, and it only ever holds the text it writes
+struct DiagramWriter
+{
+    ReportBuffer& out;
+    std::string_view current;
+    long long count;
+
+    DiagramWriter(ReportBuffer& buffer) : out(buffer), count(0) {}
+
+    // a task named name running for times time units
+    void add(std::string_view name, long long times)
+    {
+        if (count > 0 && name == current)
+        {
+            count += times;
+            return;
+        }
+        flush(", ");
+        current = name;
+        count = times;
+    }
+
+    void addIdle(long long times)
+    {
+        add("Idle", times);
+    }
+
+    void flush(std::string_view separator)
+    {
+        if (count > 0)
+        {
+            out << current << '(' << count << ')' << separator;
+        }
+    }
+
+    // writes the last run, without a separator after it
+    void finish()
+    {
+        flush("");
+        count = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "Scheduler.h"
+
+// what the random task sets look like
+struct GeneratorSettings
+{
+    int tasks;                  // tasks per set
+    double utilization;         // total utilization of every set
+    long long periodMin;        // periods are log-uniform in [periodMin, periodMax]
+    long long periodMax;
+    long long granularity;      // and rounded to a multiple of this, which keeps hyperperiods down
+    long long hyperperiodLimit; // a set whose hyperperiod is longer gets drawn again, 0 for no limit
+    int attempts;               // how often a set is drawn again before it is kept anyway
+};
+
+struct GeneratedTask
+{
+    std::string name;
+    long long wcet;
+    long long period;
+};
+
+// UUniFast (Bini and Buttazzo): n task utilizations that add up to total, uniformly spread over
+// all the ways of doing that
+inline std::vector<double> uunifast(int n, double total, std::mt19937_64& rng)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> utils(n);
+    double left = total;
+    for (int i = 0; i < n - 1; i++)
+    {
+        double next = left * std::pow(uniform(rng), 1.0 / (n - 1 - i));
+        utils[i] = left - next;
+        left = next;
+    }
+    if (n > 0)
+    {
+        utils[n - 1] = left;
+    }
+    return utils;
+}
+
+// a period drawn log-uniformly from [periodMin, periodMax], rounded to the granularity
+inline long long logUniformPeriod(const GeneratorSettings& settings, std::mt19937_64& rng)
+{
+    std::uniform_real_distribution<double> exponent(std::log((double)settings.periodMin), std::log((double)settings.periodMax + 1));
+    long long period = (long long)std::exp(exponent(rng));
+    long long step = settings.granularity > 0 ? settings.granularity : 1;
+    period = period / step * step;
+    return period < step ? step : period;
+}
+
+// task i is called by a single letter so PA3-OS can read the set too. I is left out, the
+// diagrams print it as Idle. after 51 tasks the names come around again
+inline std::string generatedName(int i)
+{
+    static const char letters[] = "ABCDEFGHJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    return std::string(1, letters[i % (sizeof(letters) - 1)]);
+}
+
+// one random task set. the wcet is the task's share of the utilization times its period,
+// at least 1, so the real utilization comes out a little off the requested one
+inline std::vector<GeneratedTask> generateSet(const GeneratorSettings& settings, std::mt19937_64& rng)
+{
+    std::vector<GeneratedTask> set;
+    for (int attempt = 1; ; attempt++)
+    {
+        std::vector<double> utils = uunifast(settings.tasks, settings.utilization, rng);
+        set.clear();
+        long long hyperPeriod = 1;
+        for (int i = 0; i < settings.tasks; i++)
+        {
+            long long period = logUniformPeriod(settings, rng);
+            long long wcet = std::llround(utils[i] * period);
+            set.push_back({ generatedName(i), wcet < 1 ? 1 : wcet, period });
+            hyperPeriod = checkedLcm(hyperPeriod, period);
+        }
+
+        bool fits = settings.hyperperiodLimit <= 0 || (hyperPeriod != HYPERPERIOD_OVERFLOW && hyperPeriod <= settings.hyperperiodLimit);
+        if (fits || attempt >= settings.attempts)
+        {
+            break;
+        }
+    }
+    return set;
+}
+
+// the set as one input line, "A 2 10 B 4 15"
+inline std::string formatSet(const std::vector<GeneratedTask>& set)
+{
+    std::string line;
+    for (size_t i = 0; i < set.size(); i++)
+    {
+        if (i)
+        {
+            line += ' ';
+        }
+        line += set[i].name + " " + std::to_string(set[i].wcet) + " " + std::to_string(set[i].period);
+    }
+    return line;
+}
+
+#endif
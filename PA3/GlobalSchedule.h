@@ -0,0 +1,209 @@
+#ifndef GLOBAL_SCHEDULE_H
+#define GLOBAL_SCHEDULE_H
+
+#include <climits>
+#include <set>
+#include <utility>
+#include <vector>
+#include "Scheduler.h"
+
+// global scheduling on a multicore: every core takes from one shared ready queue, and at any
+// moment the (up to) cores highest priority ready jobs are the ones running.
+//   GLOBAL_RM   fixed priorities, the order the tasks are handed over in
+//   GLOBAL_EDF  the job with the earliest absolute deadline first (deadline = next release)
+// like simulateRMSBetween it is event driven, it jumps from one release or completion to the
+// next, so the cost grows with the number of jobs and not with the length of the timeline.
+//
+// unlike the single cpu simulator every job is kept apart: a job that is still running at its
+// deadline is a miss, and the next job of that task waits behind it (a task never runs on two
+// cores at once)
+// --global takes at most this many cores, every one of them gets its own line in the diagram
+const int MAX_GLOBAL_CORES = 1024;
+
+enum GlobalPolicy
+{
+    GLOBAL_RM,
+    GLOBAL_EDF
+};
+
+struct GlobalCounters
+{
+    long long jobs;        // released
+    long long misses;      // jobs still unfinished at their deadline
+    long long preemptions; // a running job pushed off its core by a higher priority one
+    long long migrations;  // a job picking up on another core than the one it left
+};
+
+// simulates [0, to) of the synchronous schedule of tasks (in rate monotonic order) on cores
+// cores. every run is reported as emit(core, task, start, length), task being an index into
+// tasks or IDLE
+template <typename Emit>
+GlobalCounters simulateGlobal(const std::vector<SimTask>& tasks, int cores, GlobalPolicy policy, long long to, Emit emit)
+{
+    size_t n = tasks.size();
+    GlobalCounters counters = { 0, 0, 0, 0 };
+    std::vector<long long> execLeft(n, 0); // of the oldest unfinished job
+    std::vector<long long> released(n, 0); // jobs so far, job j comes out at j * period
+    std::vector<long long> finished(n, 0);
+    std::vector<int> coreOf(n, -1);        // where the oldest unfinished job last ran, -1 if it hasn't yet
+    std::set<std::pair<long long, int>> ready; // (priority, task), smallest first
+    std::vector<int> onCore(cores, IDLE);  // what each core ran in the last step, IDLE if that finished
+    std::vector<int> next(cores, IDLE);
+    std::vector<int> chosen;
+    ReleaseCalendar calendar;
+    calendar.reset(n);
+
+    // the oldest unfinished job is due when the next one comes out
+    auto priority = [&](int k) -> long long
+    {
+        if (policy == GLOBAL_RM)
+        {
+            return k;
+        }
+        return tasks[k].period > 0 ? (finished[k] + 1) * tasks[k].period : LLONG_MAX;
+    };
+
+    auto release = [&](int k)
+    {
+        counters.jobs++;
+        if (finished[k] < released[k])
+        {
+            counters.misses++; // the job before this one was due right now
+        }
+        released[k]++;
+        if (tasks[k].wcet <= 0)
+        {
+            finished[k] = released[k]; // nothing to do
+        }
+        else if (finished[k] + 1 == released[k])
+        {
+            execLeft[k] = tasks[k].wcet; // nothing was pending, it becomes ready
+            ready.insert({ priority(k), k });
+        }
+    };
+
+    for (size_t k = 0; k < n; k++)
+    {
+        if (tasks[k].period > 0)
+        {
+            calendar.add((int)k, 0);
+        }
+        else
+        {
+            release((int)k); // one job and never another one
+        }
+    }
+
+    long long now = 0;
+    while (true)
+    {
+        while (!calendar.empty() && calendar.nextTime() == now)
+        {
+            int k = calendar.top();
+            if (now < to)
+            {
+                release(k);
+            }
+            else if (finished[k] < released[k])
+            {
+                counters.misses++; // due right at the end, nothing comes out after it
+            }
+            calendar.advanceTop(now + tasks[k].period);
+        }
+        if (now >= to)
+        {
+            break;
+        }
+
+        // the top jobs stay on the core they were on, the others get the free cores in order
+        chosen.clear();
+        for (std::set<std::pair<long long, int>>::const_iterator it = ready.begin(); it != ready.end() && (int)chosen.size() < cores; ++it)
+        {
+            chosen.push_back(it->second);
+        }
+        std::fill(next.begin(), next.end(), IDLE);
+        for (size_t i = 0; i < chosen.size(); i++)
+        {
+            int c = coreOf[chosen[i]];
+            if (c >= 0 && onCore[c] == chosen[i])
+            {
+                next[c] = chosen[i];
+            }
+        }
+        int freeCore = 0;
+        for (size_t i = 0; i < chosen.size(); i++)
+        {
+            int k = chosen[i];
+            int c = coreOf[k];
+            if (c >= 0 && next[c] == k)
+            {
+                continue;
+            }
+            if (c >= 0 && next[c] == IDLE)
+            {
+                next[c] = k; // back on the core it left
+                continue;
+            }
+            while (next[freeCore] != IDLE)
+            {
+                freeCore++;
+            }
+            if (c >= 0 && c != freeCore)
+            {
+                counters.migrations++;
+            }
+            next[freeCore] = k;
+            coreOf[k] = freeCore;
+        }
+        for (int c = 0; c < cores; c++)
+        {
+            if (onCore[c] != IDLE && coreOf[onCore[c]] == c && next[c] != onCore[c])
+            {
+                counters.preemptions++; // its job isn't done, else onCore[c] would be IDLE
+            }
+        }
+
+        // until the next release, or until the first of the running jobs is done
+        long long until = to;
+        if (!calendar.empty() && calendar.nextTime() < until)
+        {
+            until = calendar.nextTime();
+        }
+        for (size_t i = 0; i < chosen.size(); i++)
+        {
+            if (now + execLeft[chosen[i]] < until)
+            {
+                until = now + execLeft[chosen[i]];
+            }
+        }
+
+        long long length = until - now;
+        for (int c = 0; c < cores; c++)
+        {
+            emit(c, next[c], now, length);
+            onCore[c] = next[c];
+            int k = next[c];
+            if (k == IDLE || (execLeft[k] -= length) > 0)
+            {
+                continue;
+            }
+
+            // done, the next job of the task (if one is waiting) takes its place in the queue
+            ready.erase({ priority(k), k });
+            finished[k]++;
+            coreOf[k] = -1;
+            onCore[c] = IDLE;
+            if (finished[k] < released[k])
+            {
+                execLeft[k] = tasks[k].wcet;
+                ready.insert({ priority(k), k });
+            }
+        }
+        now = until;
+    }
+
+    countTicks(now);
+    return counters;
+}
+
+#endif
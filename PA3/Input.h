@@ -0,0 +1,285 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// stdin that isn't a file is read this much at a time
+const size_t READ_CHUNK = 1 << 20;
+
+// one input line, pointing straight into the mapped file or the read buffer. keep holds on to
+// that memory, so a line can be handed to another thread without copying it
+struct InputLine
+{
+    std::string_view text;
+    std::shared_ptr<const char> keep;
+};
+
+// splits the input into lines without copying them. a regular file (named, or redirected to stdin)
+// is memory mapped; anything else, like a pipe, is read in READ_CHUNK pieces and only the line
+// that straddles two pieces gets moved. lines keep a trailing '\r' the same way getline did.
+// with recordEnd set it splits binary records instead (Binary.h), a record cut off by the end
+// of the input is dropped and cutOff() tells about it
+struct LineReader
+{
+    int fd;
+    bool ownFd;
+    std::shared_ptr<const char> buffer; // mapping or current chunk
+    const char* pos;                    // next unread byte in buffer
+    const char* end;                    // end of the valid bytes in buffer
+    bool eof;                           // nothing left to read, what is in buffer is all there is
+    const char* (*recordEnd)(const char* pos, const char* end); // end of the record at pos, NULL if it isn't all in yet
+
+    LineReader() : fd(-1), ownFd(false), pos(NULL), end(NULL), eof(false), recordEnd(NULL) {}
+
+    ~LineReader()
+    {
+        if (ownFd)
+        {
+            close(fd);
+        }
+    }
+
+    // path NULL means stdin, false if the file can't be opened
+    bool open(const char* path)
+    {
+        fd = path ? ::open(path, O_RDONLY) : STDIN_FILENO;
+        ownFd = path != NULL;
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        {
+            void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED)
+            {
+                madvise(map, info.st_size, MADV_SEQUENTIAL);
+                size_t length = info.st_size;
+                buffer = std::shared_ptr<const char>((const char*)map, [length](const char* p) { munmap((void*)p, length); });
+                pos = buffer.get();
+                end = pos + length;
+                eof = true;
+            }
+        }
+        return true;
+    }
+
+    // reads the next chunk, carrying over the unfinished line at the end of the old one
+    void refill()
+    {
+        size_t carry = end - pos;
+        size_t size = carry + READ_CHUNK > 2 * carry ? carry + READ_CHUNK : 2 * carry;
+        char* chunk = new char[size];
+        if (carry)
+        {
+            memcpy(chunk, pos, carry);
+        }
+
+        ssize_t got;
+        do
+        {
+            got = read(fd, chunk + carry, size - carry);
+        } while (got < 0 && errno == EINTR);
+
+        buffer = std::shared_ptr<const char>(chunk, std::default_delete<const char[]>());
+        pos = chunk;
+        end = chunk + carry + (got > 0 ? got : 0);
+        if (got <= 0)
+        {
+            eof = true;
+        }
+    }
+
+    // the magic a binary input starts with, false (and nothing read past it) if it isn't there
+    bool skip(std::string_view magic)
+    {
+        while ((size_t)(end - pos) < magic.size() && !eof)
+        {
+            refill();
+        }
+        if ((size_t)(end - pos) < magic.size() || std::string_view(pos, magic.size()) != magic)
+        {
+            return false;
+        }
+        pos += magic.size();
+        return true;
+    }
+
+    bool nextRecord(InputLine& line)
+    {
+        while (true)
+        {
+            const char* stop = pos ? recordEnd(pos, end) : NULL;
+            if (stop)
+            {
+                line.text = std::string_view(pos, stop - pos);
+                line.keep = buffer;
+                pos = stop;
+                return true;
+            }
+            if (eof)
+            {
+                return false;
+            }
+            refill();
+        }
+    }
+
+    // true once next() ran out on a record the input ends in the middle of
+    bool cutOff() const
+    {
+        return recordEnd && eof && pos && pos != end;
+    }
+
+    bool next(InputLine& line)
+    {
+        if (recordEnd)
+        {
+            return nextRecord(line);
+        }
+
+        while (true)
+        {
+            const char* newline = pos ? (const char*)memchr(pos, '\n', end - pos) : NULL;
+            if (newline)
+            {
+                line.text = std::string_view(pos, newline - pos);
+                line.keep = buffer;
+                pos = newline + 1;
+                return true;
+            }
+
+            if (eof)
+            {
+                break;
+            }
+            refill();
+        }
+
+        // last line without a newline at the end
+        if (pos != end)
+        {
+            line.text = std::string_view(pos, end - pos);
+            line.keep = buffer;
+            pos = end;
+            return true;
+        }
+        return false;
+    }
+};
+
+// whitespace the way the stream extraction operators see it in the C locale
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// a cursor over one line that reads fields in place, mirroring what operator>> did:
+// leading whitespace is skipped, numbers may have a sign and stop at the first non-digit,
+// and a field that isn't there or doesn't fit in an int fails
+struct FieldCursor
+{
+    const char* pos;
+    const char* end;
+
+    FieldCursor(std::string_view text) : pos(text.data()), end(text.data() + text.size()) {}
+
+    void skipBlanks()
+    {
+        while (pos != end && isBlank(*pos))
+        {
+            pos++;
+        }
+    }
+
+    // a whitespace separated word (operator>> into a std::string)
+    bool word(std::string_view& out)
+    {
+        skipBlanks();
+        const char* start = pos;
+        while (pos != end && !isBlank(*pos))
+        {
+            pos++;
+        }
+        out = std::string_view(start, pos - start);
+        return pos != start;
+    }
+
+    // a single character (operator>> into a char)
+    bool character(char& out)
+    {
+        skipBlanks();
+        if (pos == end)
+        {
+            return false;
+        }
+        out = *pos++;
+        return true;
+    }
+
+    bool integer(int& out)
+    {
+        skipBlanks();
+        const char* start = pos;
+        if (start != end && *start == '+' && start + 1 != end && *(start + 1) != '-')
+        {
+            start++; // from_chars takes '-' but not '+'
+        }
+
+        std::from_chars_result result = std::from_chars(start, end, out);
+        if (result.ec != std::errc())
+        {
+            return false;
+        }
+        pos = result.ptr;
+        return true;
+    }
+};
+
+// a command line value that has to be a whole number of at least minimum, nothing before or after it
+inline bool numberOption(const char* text, long long minimum, long long& value)
+{
+    std::string_view field(text);
+    long long parsed;
+    std::from_chars_result read = std::from_chars(field.data(), field.data() + field.size(), parsed);
+    if (read.ec != std::errc() || read.ptr != field.data() + field.size() || parsed < minimum)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+inline bool positiveOption(const char* text, long long& value)
+{
+    return numberOption(text, 1, value);
+}
+
+// a command line value that has to be one of choices, its place among them or -1 if it isn't
+inline int choiceOption(const char* text, std::initializer_list<std::string_view> choices)
+{
+    int k = 0;
+    for (std::string_view choice : choices)
+    {
+        if (choice == text)
+        {
+            return k;
+        }
+        k++;
+    }
+    return -1;
+}
+
+#endif
@@ -5,315 +5,247 @@
 #include <string>
 #include <numeric>
 #include <queue>
-#include <iomanip>
 #include <cmath>
 #include <algorithm>
 #include <vector>
+#include <deque>
+#include "Rms.h"
 
 
-struct Task
+// shared by the worker pool: the sets the reader has queued up and the writer their reports go to
+struct Pool
 {
-    char id;
-    int wcet;
-    int period;
-    int execLeft;
+    std::deque<Info*> queue;
+    bool closed;             // the reader is done
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    OrderedWriter* writer;
+};
 
-    // operator overload for algorithm scheduling
-    bool operator<(const Task& other) const
+// keeps running RMS (or EDF) on the next queued set until the reader is done and the queue is empty
+void* worker(void* void_ptr)
+{
+    Pool* pool = (Pool*)void_ptr;
+    while (true)
     {
-        if (execLeft == 0 && other.execLeft == 0)
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->queue.empty() && !pool->closed)
         {
-            return period > other.period;
+            pthread_cond_wait(&pool->notEmpty, &pool->mutex);
         }
-        if (execLeft == 0)
+        if (pool->queue.empty())
         {
-            return execLeft < other.execLeft;
+            pthread_mutex_unlock(&pool->mutex);
+            break;
         }
-        if (other.execLeft == 0)
+        Info* info = pool->queue.front();
+        pool->queue.pop_front();
+        pthread_mutex_unlock(&pool->mutex);
+
+        SetProbe probe; // performance counters, nothing unless built with PA3_STATS
+        probe.start();
+        readSet(info);
+        probe.parsed();
+
+        // written into this worker's buffer, which the writer swaps for the spare one in the slot
+        ReportBuffer& report = workerBuffer();
+        report.clear();
+        info->report = &report;
+        if (info->algorithm == EARLIEST_DEADLINE_FIRST)
         {
-            return execLeft < other.execLeft;
+            EDF(info);
         }
-        if (period == other.period)
+        else
         {
-            return id > other.id;
+            RMS(info);
         }
-        return period > other.period;
-    }
-};
+        probe.analyzed();
+        probe.record(info->CPUnum, report.text.size());
 
-struct Info
-{
-    std::vector<Task> tasks;
-    int CPUnum;
-    double utilization;
-    int hyperPeriod;
-    double setNum;
-    std::string output;
-};
-
-// calculates utilization for each set of tasks
-double setUtilization(const std::vector<Task>& tasks)
-{
-    double util = 0;
-    // gets the sum of WCET / period
-    for (const auto& task : tasks)
-    {
-        util += float(task.wcet) / task.period;
+        // sets with tasks are followed by a gap, unless they turn out to be the last one
+        pool->writer->deliver(info->CPUnum, report.text, info->tasks.empty() || info->binaryOut ? "" : "\n\n\n");
+        delete info;
     }
-    return util;
+    return NULL;
 }
 
-// calculates hyperperiod for each set of tasks
-int hyperPeriod(const std::vector<Task>& tasks)
-{
-    int hPeriod = 1;
-    for (const auto& task : tasks)
-    {
-        hPeriod = std::lcm(hPeriod, task.period);
-    }
-    return hPeriod;
-}
+/*
 
-// sorts the vector of tasks based on the period in ascending order
-bool tasksPriority(const Task a, const Task b)
-{
-    return a.period < b.period;
-}
+A 2 10 B 4 15 C 3 30
+X 10 25 Y 5 10 Z 1 20
+A 1 5 B 5 20 c 1 10 D 1 5
 
-std::string convertToDiagram(std::string in)
-{
-    std::stringstream result;
-    char currChar = '\0';
-    int currCount = 0;
+*/
 
-    for (size_t i = 0; i < in.size(); ++i)
+
+int main(int argc, char* argv[])
+{
+    InputLine line;
+
+    // --window-limit N: hyperperiods longer than N only get their busy period simulated
+    // --input FILE: read FILE instead of stdin
+    // --stats FILE, --stats-format json|csv: performance counters, needs a build with -DPA3_STATS
+    // --input-format text|binary: sets in the binary format of Binary.h
+    // --output-format text|binary: result records in the format of Binary.h, for rate monotonic only.
+    //   they are the records PA3 writes, so Convert.cpp turns them into PA3's report and not this one
+    // --policy rm|edf: rate monotonic (the default) or earliest deadline first
+    long long windowLimit = DEFAULT_WINDOW_LIMIT;
+    bool binary = false, binaryOut = false;
+    Algorithm algorithm = RATE_MONOTONIC;
+    const char* inputPath = NULL;
+    std::string statsPath, statsFormat = "json";
+    for (int i = 1; i < argc; i++)
     {
-        char c = in[i];
-        if (c == currChar)
+        if (std::string(argv[i]) == "--window-limit" && i + 1 < argc)
         {
-            currCount++;
+            if (!positiveOption(argv[++i], windowLimit))
+            {
+                std::cerr << "--window-limit needs a positive number of time units" << std::endl;
+                return 1;
+            }
         }
-        else
+        else if (std::string(argv[i]) == "--input" && i + 1 < argc)
         {
-            if (currCount > 0)
+            inputPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--stats" && i + 1 < argc)
+        {
+            statsPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--stats-format" && i + 1 < argc)
+        {
+            statsFormat = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--input-format" && i + 1 < argc)
+        {
+            int choice = choiceOption(argv[++i], { "text", "binary" });
+            if (choice < 0)
             {
-                if (currChar == 'I')
-                {
-                    result << "Idle(" << currCount << "), ";
-                }
-                else
-                {
-                    result << currChar << "(" << currCount << "), ";
-                }
+                std::cerr << "--input-format needs text or binary" << std::endl;
+                return 1;
             }
-
-            currChar = c;
-            currCount = 1;
+            binary = choice == 1;
         }
-    }
-
-    // last character
-    if (currCount > 0)
-    {
-        if (currChar == 'I')
+        else if (std::string(argv[i]) == "--output-format" && i + 1 < argc)
         {
-            result << "Idle(" << currCount << ")";
+            int choice = choiceOption(argv[++i], { "text", "binary" });
+            if (choice < 0)
+            {
+                std::cerr << "--output-format needs text or binary" << std::endl;
+                return 1;
+            }
+            binaryOut = choice == 1;
         }
-        else
+        else if (std::string(argv[i]) == "--policy" && i + 1 < argc)
         {
-            result << currChar << "(" << currCount << ")";
+            int choice = choiceOption(argv[++i], { "rm", "edf" });
+            if (choice < 0)
+            {
+                std::cerr << "--policy needs rm or edf" << std::endl;
+                return 1;
+            }
+            algorithm = choice == 1 ? EARLIEST_DEADLINE_FIRST : RATE_MONOTONIC;
         }
     }
 
-    return result.str();
-
-}
-
-bool compareTasks(const Task a, const Task b)
-{
-    return a.period < b.period;
-}
-
-void* RMS(void* void_ptr)
-{
-    // cast void pointer to a struct of type Info
-    Info* infoPtr = (Info*)void_ptr;
-    // queue for algorithm
-    std::priority_queue<Task> Q;
-    for (int i = 0; i < infoPtr->tasks.size(); i++)
+    LineReader reader;
+    if (!reader.open(inputPath))
     {
-        Q.push(infoPtr->tasks.at(i));
+        std::cerr << "Error opening " << inputPath << std::endl;
+        return 1;
     }
-
-
-    // calculate the utilization for the set of tasks
-    infoPtr->utilization = setUtilization(infoPtr->tasks);
-    // calculate the hyperperiod for the set of tasks
-    infoPtr->hyperPeriod = hyperPeriod(infoPtr->tasks);
-
-    // check if the tasks are schedulable
-    infoPtr->setNum = infoPtr->tasks.size() * (pow(2, float(1) / infoPtr->tasks.size()) - 1);
-
-    infoPtr->output = "";
-    std::string line = "";
-    if (infoPtr->utilization > 1)
+    if (binary)
     {
-        infoPtr->output += "The task set is not schedulable";
+        reader.recordEnd = setRecordEnd;
+        if (!reader.skip(SET_MAGIC))
+        {
+            std::cerr << "The input is not a binary task set file" << std::endl;
+            return 1;
+        }
     }
-    else if (infoPtr->utilization <= infoPtr->setNum)
+    if (binaryOut)
     {
-        // execute algorithm
-        infoPtr->output += "Scheduling Diagram for CPU " + std::to_string(infoPtr->CPUnum) + ": ";
-
-        for (int i = 1; i <= infoPtr->hyperPeriod; i++)
+        if (algorithm != RATE_MONOTONIC)
         {
-            Task curr = Q.top();
-
-            // if there are tasks left to execute
-            if (curr.execLeft > 0)
-            {
-                Q.pop();
-
-                // add to output string
-                line += std::string(1, curr.id);
-
-                curr.execLeft--;
-                Q.push(curr);
-
-                std::priority_queue<Task> temp;
-
-                // check if Task crossed their time period to reset
-                while (!Q.empty())
-                {
-                    Task curr = Q.top();
-                    Q.pop();
-
-                    if (i % curr.period == 0 && i != 1)
-                    {
-                        curr.execLeft += curr.wcet;
-                    }
-
-                    temp.push(curr);
-                }
-
-                Q = temp;
-            }
-            else
-            {
-                line.append("I");
-                std::priority_queue<Task> temp;
-
-                while (!Q.empty())
-                {
-                    Task curr = Q.top();
-                    Q.pop();
-
-                    if (i % curr.period == 0 && i != 1)
-                    {
-                        curr.execLeft += curr.wcet;
-                    }
+            std::cerr << "--output-format binary only goes with rate monotonic analysis" << std::endl;
+            return 1;
+        }
+        std::vector<struct iovec> magic(1, { (void*)RESULT_MAGIC.data(), RESULT_MAGIC.size() });
+        writeAll(STDOUT_FILENO, magic);
+    }
 
-                    temp.push(curr);
-                }
+    // three stages: this thread reads sets, the pool runs RMS on them and the writer prints them
+    // in CPU order as soon as they are done. only IN_FLIGHT sets are between reader and writer
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int nThreads = std::max<long>(cores, 1);
 
-                Q = temp;
-            }
-        }
+    OrderedWriter writer(IN_FLIGHT);
+    Pool pool;
+    pool.closed = false;
+    pool.writer = &writer;
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.notEmpty, NULL);
+    std::vector<pthread_t> tid(nThreads);
 
-        infoPtr->output += convertToDiagram(line);
+    if ((!statsPath.empty() && !startStats(statsPath, statsFormat)) || !writer.start())
+    {
+        std::cerr << "Error creating thread" << std::endl;
+        return 1;
     }
-    else
+    for (int i = 0; i < nThreads; i++)
     {
-        infoPtr->output += "Task set schedulability is unknown";
+        if (pthread_create(&tid[i], nullptr, worker, &pool))
+        {
+            std::cerr << "Error creating thread" << std::endl;
+            return 1;
+        }
     }
 
-    return NULL;
-}
-
-/*
-
-A 2 10 B 4 15 C 3 30
-X 10 25 Y 5 10 Z 1 20
-A 1 5 B 5 20 c 1 10 D 1 5
-
-*/
-
-
-int main()
-{
-    std::vector<Info> input;
-    std::string line = "";
-
-    // read tasks from input
-    while (getline(std::cin, line))
+    // read tasks from input, the workers parse them
+    long long sets = 0;
+    while (reader.next(line))
     {
-        if (line == "exit")
+        if (!binary && line.text == "exit")
         {
             break;
         }
-        int found = line.find("1");
-        if (found != -1)
+        sets++;
+        // the text filter on a "1" somewhere in the line has nothing to look at in a binary set
+        if (binary || line.text.find("1") != std::string_view::npos)
         {
-            std::stringstream parseInput(line);
-            Task tempTask;
-            std::vector<Task> tasksInput;
-            while (parseInput >> tempTask.id >> tempTask.wcet >> tempTask.period)
-            {
-                tempTask.execLeft = tempTask.wcet;
-                tasksInput.push_back(tempTask);
-            }
-            input.push_back({ tasksInput });
+            Info* info = new Info;
+            info->line = line;
+            info->binary = binary;
+            info->binaryOut = binaryOut;
+            info->algorithm = algorithm;
+            info->windowLimit = windowLimit;
+            info->CPUnum = writer.reserve(); // waits while the writer is too far behind
+
+            pthread_mutex_lock(&pool.mutex);
+            pool.queue.push_back(info);
+            pthread_cond_signal(&pool.notEmpty);
+            pthread_mutex_unlock(&pool.mutex);
         }
     }
-    // intialize number of threads
-    int nThreads = input.size();
-    pthread_t* tid = new pthread_t[nThreads];
 
-    for (int i = 0; i < input.size(); i++)
-    {
-        input.at(i).CPUnum = i + 1;
-        if (pthread_create(&tid[i], nullptr, RMS, &input.at(i)))
-        {
-            std::cerr << "Error creating thread" << std::endl;
-            return 1;
-        }
-    }
+    pthread_mutex_lock(&pool.mutex);
+    pool.closed = true;
+    pthread_cond_broadcast(&pool.notEmpty);
+    pthread_mutex_unlock(&pool.mutex);
 
     for (int i = 0; i < nThreads; i++)
     {
         pthread_join(tid[i], nullptr);
     }
+    writer.close();
+    writer.join();
+    writeStats();
+    //std::cout << "\nFinished Program";
 
-    // CPU loop
-    for (int i = 0; i < nThreads; i++)
+    if (reader.cutOff())
     {
-        std::cout << "CPU " << i + 1 << std::endl;
-        // output task information
-        std::cout << "Task scheduling information: ";
-        for (int j = 0; j < input.at(i).tasks.size(); j++)
-        {
-            if (j < input.at(i).tasks.size() - 1)
-            {
-                std::cout << input.at(i).tasks.at(j).id << " (WCET: " << input.at(i).tasks.at(j).wcet << ", Period: " << input.at(i).tasks.at(j).period << "), ";
-            }
-            else
-            {
-                std::cout << input.at(i).tasks.at(j).id << " (WCET: " << input.at(i).tasks.at(j).wcet << ", Period: " << input.at(i).tasks.at(j).period << ")\n";
-
-                std::cout << "Task set utilization: " << std::fixed << std::setprecision(2) << input.at(i).utilization << std::endl;
-                std::cout << "Hyperperiod: " << input.at(i).hyperPeriod << std::endl;
-                if (i < nThreads - 1)
-                {
-                    std::cout << "Rate Monotonic Algorithm execution for CPU" << i + 1 << ": \n" << input.at(i).output << "\n\n\n";
-                }
-                else
-                {
-                    std::cout << "Rate Monotonic Algorithm execution for CPU" << i + 1 << ": \n" << input.at(i).output;
-                }
-            }
-        }
+        std::cerr << "The input ends partway through set " << sets + 1 << std::endl;
+        return 1;
     }
-    //std::cout << "\nFinished Program";
-
     return 0;
 }
\ No newline at end of file
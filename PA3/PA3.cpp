@@ -3,347 +3,314 @@
 #include <vector>
 #include <unistd.h>
 #include <queue>
-#include <sstream>
-#include <iomanip>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include "Rmsa.h"
 
-struct args
-{
-    std::string in; // input
-    // std::string out;                   // output
-    int num;                           // which call it is
-    int* next;                         // for calling in next thread
-    pthread_mutex_t* input_copy_mutex; // for shared data
-    pthread_mutex_t* print_mutex;      // for printing
-    pthread_cond_t* condition;         // The condition variable.
-};
-
-// node will be the main struct used for each task
-struct node
-{
-    std::string name; // stores the task name
-    int wceTime;      // stores the task worst case execution time
-    int period;       // stores the task period
-    int execLeft;     // stores how many executions this task has left in the period
-
-    node(std::string n, int w, int p, int e) : name(n), wceTime(w), period(p), execLeft(e) {}
-
-    // this helps us decide what priority will be in our pQueue
-    bool operator<(const node& other) const
-    {
-        if (execLeft == 0 && other.execLeft == 0)
-            return period > other.period;
-
-        if (execLeft == 0)
-            return execLeft < other.execLeft;
-
-        if (other.execLeft == 0)
-            return execLeft < other.execLeft;
-
-        if (period == other.period)
-            return name > other.name;
-
-        return period > other.period;
-    }
-};
-
-int gcd(int a, int b) // helper for lcm
+// --serve: the same jobs as for lines from stdin, on a pool and a cache that stay up for as long as
+// the server does. every client gets its own report numbers, counting from 1
+int serve(args x, const char* path, int partitions, FitHeuristic fit, const std::string& statsPath, const std::string& statsFormat, bool cacheStats)
 {
-    while (b)
+    LineServer server;
+    if (!server.open(path))
     {
-        a %= b;
-        std::swap(a, b);
+        std::cerr << "Error listening on " << path << ": " << strerror(errno) << std::endl;
+        return 1;
     }
-    return a;
-}
 
-int lcm(int a, int b) // lcm using gcd
-{
-    int temp = gcd(a, b);
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    StealingPool workers(cores < 1 ? 1 : (int)cores);
+    StealingThreads threads;
+    x.pool = &workers;
+    x.writer = NULL;
 
-    return temp ? (a / temp * b) : 0;
-}
-
-// used to calculate hyperPeriod
-int calculateHyperPeriod(const std::priority_queue<node>& tasks)
-{
-    if (tasks.empty())
+    workers.hold(); // the workers wait for clients instead of going home
+    if ((!statsPath.empty() && !startStats(statsPath, statsFormat)) || !threads.start(workers))
     {
-        return 0;
+        std::cerr << "Error creating thread" << std::endl;
+        return 1;
     }
 
-    int hyperPeriod = tasks.top().period;
+    // the lines of one round of reads, from every client that had something, go out as one batch
+    std::vector<Job> batch;
+    size_t count = 0;
+    server.run([&](const std::shared_ptr<Connection>& client, const InputLine& line)
+    {
+        if (partitions > 0)
+        {
+            partitionArgs* pool = new partitionArgs{ x, (int)client->lines, partitions, fit };
+            pool->Boat.in = line;
+            pool->Boat.reply = client;
+            pool->Boat.num = client->reserved + 1;
+            client->reserved += 1 + partitions; // the summary and the CPUs after it
+            batch.push_back({ runPartition, pool });
+            return;
+        }
 
-    std::priority_queue<node> temp = tasks;
-    while (!temp.empty())
+        args* job = new args(x);
+        job->in = line;
+        job->reply = client;
+        job->num = ++client->reserved;
+        job->cpu = job->num;
+        batch.push_back({ runRMSA, job });
+    }, [&]()
+    {
+        workers.pushAll(batch, count);
+        count += batch.size();
+        batch.clear();
+    });
+
+    workers.release();
+    threads.join();
+    server.close();
+    writeStats();
+    if (cacheStats && x.cache)
     {
-        node current = temp.top();
-        temp.pop();
-        hyperPeriod = lcm(hyperPeriod, current.period);
+        x.cache->writeCounters(stderr);
     }
-
-    return hyperPeriod;
-}
-
-// this calculates the expression where "Task set schedulability is unknown"
-double calculateExpression(int n)
-{
-    return n * (std::pow(2.0, 1.0 / n) - 1);
+    return 0;
 }
 
-// this function takes the string I create throughout the program and outputs it formatted.
-std::string convertToTaskSchedule(const std::string& input)
+int main(int argc, char* argv[])
 {
-    std::ostringstream resultStream;
-    char currentChar = '\0';
-    int currentCount = 0;
 
-    for (size_t i = 0; i < input.size(); ++i)
+    struct args x;
+    x.windowLimit = DEFAULT_WINDOW_LIMIT;
+    x.cores = 0;
+    x.algorithm = RATE_MONOTONIC;
+    x.binaryIn = false;
+    x.binaryOut = false;
+
+    // --window-limit N: hyperperiods longer than N only get their busy period simulated
+    // --input FILE: read FILE instead of stdin
+    // --stats FILE, --stats-format json|csv: performance counters, needs a build with -DPA3_STATS
+    // --cache-size BYTES: memory for results of sets seen before, 0 turns the cache off
+    // --cache-names remap|exact: whether a hit may come from the same set under other names
+    // --cache-stats: print the cache's hits and misses to stderr at the end
+    // --partition M: every line is a pool of tasks to pack onto M CPUs instead of one CPU
+    // --fit first|best: how --partition picks a CPU for a task, first fit by default
+    // --global M: simulate every set on M cores with one shared ready queue
+    // --policy rm|edf: rate monotonic (the default) or earliest deadline first, on one cpu or with --global
+    // --serve PATH: stay up and answer clients on the unix socket at PATH instead of reading the input
+    // --input-format text|binary, --output-format text|binary: the binary formats in Binary.h, Convert.cpp
+    //   turns them back into text. binary output is for plain rate monotonic analysis only
+    const char* inputPath = NULL;
+    const char* servePath = NULL;
+    std::string statsPath, statsFormat = "json";
+    long long cacheSize = DEFAULT_CACHE_SIZE;
+    bool remapNames = true, cacheStats = false;
+    int partitions = 0;
+    FitHeuristic fit = FIRST_FIT;
+    for (int i = 1; i < argc; i++)
     {
-        char c = input[i];
-        if (c == currentChar)
+        if (std::string(argv[i]) == "--window-limit" && i + 1 < argc)
         {
-            currentCount++;
+            // part of the cache key too, so no quietly falling back to something else
+            if (!positiveOption(argv[++i], x.windowLimit))
+            {
+                std::cerr << "--window-limit needs a positive number of time units" << std::endl;
+                return 1;
+            }
         }
-        else
+        else if (std::string(argv[i]) == "--input" && i + 1 < argc)
+        {
+            inputPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--stats" && i + 1 < argc)
+        {
+            statsPath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--stats-format" && i + 1 < argc)
         {
-            if (currentCount > 0)
+            statsFormat = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--cache-size" && i + 1 < argc)
+        {
+            if (!numberOption(argv[++i], 0, cacheSize))
             {
-                if (currentChar == 'I')
-                {
-                    resultStream << "Idle(" << currentCount << "), ";
-                }
-                else
-                {
-                    resultStream << currentChar << "(" << currentCount << "), ";
-                }
+                std::cerr << "--cache-size needs a number of bytes, 0 or more" << std::endl;
+                return 1;
             }
-            currentChar = c;
-            currentCount = 1;
         }
-    }
-
-    // Add the last character count
-    if (currentCount > 0)
-    {
-        if (currentChar == 'I')
+        else if (std::string(argv[i]) == "--cache-names" && i + 1 < argc)
         {
-            resultStream << "Idle(" << currentCount << ")";
+            remapNames = std::string(argv[++i]) != "exact";
         }
-        else
+        else if (std::string(argv[i]) == "--cache-stats")
         {
-            resultStream << currentChar << "(" << currentCount << ")";
+            cacheStats = true;
         }
-    }
-
-    return resultStream.str();
-}
-
-// here is my function used in multi-threading
-void* RMSA(void* x_void_ptr) // RMSA --> Rate Monotonic Scheduling Algorithm
-{
-    args Boat = *(args*)x_void_ptr;             // Deinitilization
-    int localNum = Boat.num;                     // turning shared resource into a local resource
-    std::string localString = Boat.in;           // turning shared resource into a local resource
-    pthread_mutex_unlock(Boat.input_copy_mutex); // unlock copying semaphore now that we have it all local
-
-    std::priority_queue<node> pq;
-    std::vector<node> Ttasks;
-    std::istringstream iss(localString);
-
-    // initializing variables
-    std::string name;
-    std::string output = "";
-    int wceTime, period;
-    int numTasks = 0;
-    double util = 0;
-    std::string out;
-
-    // pushing into two queues, one to help me print, one to be priority
-    while (iss >> name >> wceTime >> period)
-    {
-        pq.push(node(name, wceTime, period, wceTime));
-        Ttasks.push_back(node(name, wceTime, period, wceTime));
-    }
-
-    // printing CPU #
-    int hyperPeriod = calculateHyperPeriod(pq);
-
-    out += "CPU " + std::to_string(localNum) + "\n";
-    out += "Task scheduling information: ";
-
-    // this for-loop gets the utilization number, as well as line one printing
-    for (std::vector<node>::const_iterator it = Ttasks.begin(); it != Ttasks.end(); ++it)
-    {
-        const node& task = *it;
-        numTasks++;
-        util = util + (static_cast<double>(task.wceTime) / static_cast<double>(task.period));
-        out += task.name + " (WCET: " + std::to_string(task.wceTime) + ", Period: " + std::to_string(task.period);
-        if (numTasks < Ttasks.size())
+        else if (std::string(argv[i]) == "--partition" && i + 1 < argc)
         {
-            out += "), "; // Print comma if it's not the last element
+            // a pool takes a slot in the output for its summary and one for every CPU, all reserved at once
+            long long cpus;
+            if (!positiveOption(argv[++i], cpus) || cpus >= (long long)IN_FLIGHT)
+            {
+                std::cerr << "--partition needs between 1 and " << IN_FLIGHT - 1 << " CPUs" << std::endl;
+                return 1;
+            }
+            partitions = (int)cpus;
         }
-        else
+        else if (std::string(argv[i]) == "--fit" && i + 1 < argc)
+        {
+            int choice = choiceOption(argv[++i], { "first", "best" });
+            if (choice < 0)
+            {
+                std::cerr << "--fit needs first or best" << std::endl;
+                return 1;
+            }
+            fit = choice == 1 ? BEST_FIT : FIRST_FIT;
+        }
+        else if (std::string(argv[i]) == "--global" && i + 1 < argc)
+        {
+            long long cores;
+            if (!positiveOption(argv[++i], cores) || cores > MAX_GLOBAL_CORES)
+            {
+                std::cerr << "--global needs between 1 and " << MAX_GLOBAL_CORES << " cores" << std::endl;
+                return 1;
+            }
+            x.cores = (int)cores;
+        }
+        else if (std::string(argv[i]) == "--policy" && i + 1 < argc)
+        {
+            int choice = choiceOption(argv[++i], { "rm", "edf" });
+            if (choice < 0)
+            {
+                std::cerr << "--policy needs rm or edf" << std::endl;
+                return 1;
+            }
+            x.algorithm = choice == 1 ? EARLIEST_DEADLINE_FIRST : RATE_MONOTONIC;
+        }
+        else if (std::string(argv[i]) == "--serve" && i + 1 < argc)
+        {
+            servePath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--input-format" && i + 1 < argc)
+        {
+            int choice = choiceOption(argv[++i], { "text", "binary" });
+            if (choice < 0)
+            {
+                std::cerr << "--input-format needs text or binary" << std::endl;
+                return 1;
+            }
+            x.binaryIn = choice == 1;
+        }
+        else if (std::string(argv[i]) == "--output-format" && i + 1 < argc)
         {
-            out += ") "; // If it's the last element, don't print comma
+            int choice = choiceOption(argv[++i], { "text", "binary" });
+            if (choice < 0)
+            {
+                std::cerr << "--output-format needs text or binary" << std::endl;
+                return 1;
+            }
+            x.binaryOut = choice == 1;
         }
     }
 
-    // more printing
-    std::stringstream utilStream;
-    utilStream << std::fixed << std::setprecision(2) << util;
-    out += "\nTask set utilization: " + utilStream.str();
+    if (x.binaryOut && (partitions > 0 || x.cores > 0 || x.algorithm != RATE_MONOTONIC))
+    {
+        std::cerr << "--output-format binary only goes with rate monotonic analysis on one CPU" << std::endl;
+        return 1;
+    }
+    if (servePath && (x.binaryIn || x.binaryOut))
+    {
+        std::cerr << "--serve only speaks the text format" << std::endl;
+        return 1;
+    }
 
-    out += "\nHyperperiod: " + std::to_string(hyperPeriod) + "\n";
-    out += "Rate Monotonic Algorithm execution for CPU " + std::to_string(localNum) + ":\n";
+    ResultCache cache(cacheSize > 0 ? (size_t)cacheSize : 0, remapNames);
+    x.cache = cacheSize > 0 ? &cache : NULL;
 
-    // logic based on utilization and formula given in directions
-    if (util > 1)
+    if (servePath)
     {
-        out += "The task set is not schedulable\n";
+        return serve(x, servePath, partitions, fit, statsPath, statsFormat, cacheStats);
     }
-    else if (util > calculateExpression(numTasks))
+
+    LineReader reader;
+    if (!reader.open(inputPath))
     {
-        out += "Task set schedulability is unknown\n";
+        std::cerr << "Error opening " << inputPath << std::endl;
+        return 1;
     }
-    else // find the scheduling diagram
+    if (x.binaryIn)
     {
-        out += "Scheduling Diagram for CPU " + std::to_string(localNum) + ": ";
-        for (int i = 1; i <= hyperPeriod; i++)
+        reader.recordEnd = setRecordEnd;
+        if (!reader.skip(SET_MAGIC))
         {
-            node current = pq.top();
-
-            // if there are still tasks to execute...
-            if (current.execLeft > 0)
-            {
-                pq.pop();
-
-                // adding to my output string which will later be formatted
-                output += current.name;
-
-                current.execLeft--;
-                pq.push(current);
-
-                std::priority_queue<node> temp;
-
-                // checking if any of the nodes have crossed thier period, in which case...
-                while (!pq.empty())
-                {
-                    node current = pq.top();
-                    pq.pop();
-
-                    if (i % current.period == 0 && i != 1)
-                    {
-
-                        current.execLeft += current.wceTime; // i need to add executions!
-                    }
-
-                    temp.push(current);
-                }
-
-                pq = temp;
-            }
-            else
-            {
-
-                output.append("I"); // will be formatted correctly later
-
-                std::priority_queue<node> temp;
-
-                // checking if any of the nodes have crossed thier period, in which case...
-                while (!pq.empty())
-                {
-                    node current = pq.top();
-                    pq.pop();
-
-                    if ((i % current.period == 0 && i != 1))
-                    {
-                        current.execLeft += current.wceTime; // i need to add executions!
-                    }
-
-                    temp.push(current);
-                }
-
-                pq = temp;
-            }
+            std::cerr << "The input is not a binary task set file" << std::endl;
+            return 1;
         }
     }
-    out += convertToTaskSchedule(output);
-    out += "\n\n";
-
-    pthread_mutex_lock(Boat.print_mutex); // second critical section --> check if num = localNum
-
-    while ((*(Boat.next)) != localNum)
+    if (x.binaryOut)
     {
-        pthread_cond_wait(Boat.condition, Boat.print_mutex); // if not set it to wait until it does
+        std::vector<struct iovec> magic(1, { (void*)RESULT_MAGIC.data(), RESULT_MAGIC.size() });
+        writeAll(STDOUT_FILENO, magic);
     }
 
-    pthread_mutex_unlock(Boat.print_mutex); // unlock crit section
-
-    std::cout << out; // print accumulated output
-
-    pthread_mutex_lock(Boat.print_mutex); // lock so we can increment the shared resource
-
-    (*Boat.next)++;
-
-    pthread_cond_broadcast(Boat.condition); // wake up other threads since now we are done
-
-    pthread_mutex_unlock(Boat.print_mutex); // unlock semaphore
-
-    return NULL;
-}
-
-int main()
-{
-
-    struct args x;
-    std::vector<std::string> store;
-    pthread_mutex_t input_copy_mutex;
-    pthread_mutex_init(&input_copy_mutex, NULL); // semaphore for copying shared resources
-
-    pthread_mutex_t print_mutex;
-    pthread_mutex_init(&print_mutex, NULL); // semaphore for printing
-
-    static pthread_cond_t condition = PTHREAD_COND_INITIALIZER;
-    static int next = 1;
-    x.input_copy_mutex = &input_copy_mutex;
-    x.print_mutex = &print_mutex;
-    x.condition = &condition;
-    x.next = &next;
+    // three stages: this thread reads lines, the pool analyzes them and the writer prints them in order.
+    // the writer only has room for IN_FLIGHT reports, so reading pauses instead of piling up input
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    StealingPool workers(cores < 1 ? 1 : (int)cores);
+    StealingThreads threads;
+    OrderedWriter writer(IN_FLIGHT);
+    x.pool = &workers;
+    x.writer = &writer;
+
+    workers.hold(); // keep the workers around until the input runs out
+    if ((!statsPath.empty() && !startStats(statsPath, statsFormat)) || !writer.start() || !threads.start(workers))
+    {
+        std::cerr << "Error creating thread" << std::endl;
+        return 1;
+    }
 
-    std::string input = "";
-    int count1 = 0; // allows me to set pthread_t tid[]
-    int count2 = 0; // allows me to make threads increment (++) each time
+    InputLine input;
+    size_t count = 0;
+    int pools = 0;
 
-    while (getline(std::cin, input))
+    // the reader only finds where lines start and end, the workers parse them in place
+    while (reader.next(input))
     {
-        if (input == "exit")
+        if (!x.binaryIn && input.text == "exit")
         {
             break;
         }
-        count1++;
-        store.push_back(input);
-    }
-
-    pthread_t tid[count1];
-
-    for (int i = 0; i < count1; i++)
-    {
-        pthread_mutex_lock(&input_copy_mutex); // Enter first critical section
-        x.in = store[i];                       // sending the input
-        x.num = count2 + 1;                    // sending which CPU# it will handle
 
-        if (pthread_create(&tid[count2], NULL, RMSA, &x)) // only using one memory address
+        if (partitions > 0)
         {
-            std::cerr << "Error creating thread" << std::endl;
-            return 1;
+            partitionArgs* pool = new partitionArgs{ x, ++pools, partitions, fit };
+            pool->Boat.in = input;
+            pool->Boat.num = writer.reserve();
+            for (int c = 0; c < partitions; c++)
+            {
+                writer.reserve(); // the CPUs come right after the summary
+            }
+            workers.push(count++ % workers.size(), { runPartition, pool }, false);
+            continue;
         }
-        count2++;
+
+        args* job = new args(x);
+        job->in = input;                 // sending the input
+        job->num = writer.reserve();     // sending which CPU# it will handle, waits while the writer is behind
+        job->cpu = job->num;
+        workers.push(count++ % workers.size(), { runRMSA, job }, false);
     }
 
-    for (int i = 0; i < count1; i++) // joining threads
-        pthread_join(tid[i], NULL);
+    writer.close();
+    workers.release();
+    threads.join();
+    writer.join();
+    writeStats();
+    if (cacheStats && x.cache)
+    {
+        x.cache->writeCounters(stderr);
+    }
 
+    if (reader.cutOff())
+    {
+        std::cerr << "The input ends partway through set " << count + 1 << std::endl;
+        return 1;
+    }
     return 0;
 }
 
@@ -0,0 +1,170 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Admission.h"
+#include "Analysis.h"
+#include "WorkStealing.h"
+
+// partitioned rate monotonic scheduling: one pool of tasks packed onto M CPUs, each CPU then
+// scheduled on its own. tasks go in by decreasing utilization, each onto
+//   FIRST_FIT  the first CPU it fits on
+//   BEST_FIT   the CPU it fits on that ends up fullest
+// a task fits when the CPU stays at or under 100%, and either under the liu-layland bound or
+// through the exact response time test of the CPU's AdmissionAnalyzer. with a pool to run on,
+// the CPUs are looked at in parallel chunks
+
+enum FitHeuristic
+{
+    FIRST_FIT,
+    BEST_FIT
+};
+
+struct PartitionTask
+{
+    std::string_view name;
+    long long wcet;
+    long long period;
+};
+
+struct Partition
+{
+    std::vector<AdmissionAnalyzer> cpus;
+    std::vector<int> cpuOf; // cpuOf[k] is where task k went, -1 if it fits nowhere
+};
+
+// fewer CPUs than this per chunk isn't worth handing to another worker
+const size_t MIN_CANDIDATES = 16;
+
+// the CPUs [from, to) looked at for one task, the best of them ends up in found
+struct CandidateScan
+{
+    Partition* partition;
+    FitHeuristic fit;
+    std::string_view key;
+    long long wcet;
+    long long period;
+    size_t from;
+    size_t to;
+    int found;   // -1 if none of them can take it
+    double load; // utilization of found with the task on it
+};
+
+// whether cpu can take the task, without putting it there
+inline bool fitsOn(AdmissionAnalyzer& cpu, std::string_view key, long long wcet, long long period, double& load)
+{
+    load = cpu.utilization + (double)wcet / (double)period;
+    if (!(load <= 1))
+    {
+        return false;
+    }
+    if (load <= liuLaylandBound(cpu.size() + 1))
+    {
+        return true;
+    }
+    return cpu.admit(key, wcet, period, false).verdict == ADMIT_OK;
+}
+
+inline void scanCandidates(void* arg)
+{
+    CandidateScan* scan = (CandidateScan*)arg;
+    scan->found = -1;
+    for (size_t c = scan->from; c < scan->to; c++)
+    {
+        double load;
+        if (!fitsOn(scan->partition->cpus[c], scan->key, scan->wcet, scan->period, load))
+        {
+            continue;
+        }
+        if (scan->found < 0 || load > scan->load)
+        {
+            scan->found = (int)c;
+            scan->load = load;
+        }
+        if (scan->fit == FIRST_FIT)
+        {
+            break;
+        }
+    }
+}
+
+// packs tasks onto cpuCount CPUs. pool may be NULL, then everything runs on the calling thread
+inline void partitionTasks(const std::vector<PartitionTask>& tasks, size_t cpuCount, FitHeuristic fit, StealingPool* pool, Partition& partition)
+{
+    partition.cpus.assign(cpuCount, AdmissionAnalyzer());
+    partition.cpuOf.assign(tasks.size(), -1);
+
+    // decreasing utilization, ties in rate monotonic order so the packing doesn't depend on luck
+    std::vector<size_t> order(tasks.size());
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        order[k] = k;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+    {
+        double ua = (double)tasks[a].wcet / (double)tasks[a].period;
+        double ub = (double)tasks[b].wcet / (double)tasks[b].period;
+        if (ua != ub)
+        {
+            return ua > ub;
+        }
+        return tasks[a].period == tasks[b].period ? tasks[a].name < tasks[b].name : tasks[a].period < tasks[b].period;
+    });
+
+    size_t chunks = pool ? std::min<size_t>(pool->size(), cpuCount / MIN_CANDIDATES) : 1;
+    chunks = std::max<size_t>(chunks, 1);
+    std::vector<CandidateScan> scans(chunks);
+    std::vector<Job> jobs(chunks);
+    std::string key;
+
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        const PartitionTask& task = tasks[order[k]];
+        if (task.wcet < 0 || task.period < 1)
+        {
+            continue; // fits nowhere
+        }
+
+        // the analyzers know tasks by name, the task number keeps two tasks of the same name
+        // apart and still ranks them by name first
+        key.assign(task.name.data(), task.name.size());
+        key += '\0';
+        key += std::to_string(order[k]);
+
+        for (size_t c = 0; c < chunks; c++)
+        {
+            scans[c] = { &partition, fit, key, task.wcet, task.period, cpuCount * c / chunks, cpuCount * (c + 1) / chunks, -1, 0 };
+            jobs[c] = { scanCandidates, &scans[c] };
+        }
+        if (chunks > 1)
+        {
+            pool->runAll(jobs);
+        }
+        else
+        {
+            scanCandidates(&scans[0]);
+        }
+
+        // the first chunk with a CPU for first fit, the fullest CPU over all chunks for best fit
+        int chosen = -1;
+        double load = 0;
+        for (size_t c = 0; c < chunks; c++)
+        {
+            if (scans[c].found >= 0 && (chosen < 0 || (fit == BEST_FIT && scans[c].load > load)))
+            {
+                chosen = scans[c].found;
+                load = scans[c].load;
+            }
+        }
+
+        if (chosen >= 0 && partition.cpus[chosen].admit(key, task.wcet, task.period).verdict == ADMIT_OK)
+        {
+            partition.cpuOf[order[k]] = chosen;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <limits.h>
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Stats.h"
+
+// how many task sets can be between the reader and the writer at once. the reader stops reading
+// once this many are in flight, so memory stays flat however big the input is
+const size_t IN_FLIGHT = 1024;
+
+// a slot keeps the memory of the report it last held so the next worker can swap it out and
+// write into it, unless it got bigger than this
+const size_t KEEP_REPORT = 1 << 16;
+
+// writes every byte in the buffers to fd with as few writev calls as it takes, false on an error
+inline bool writeAll(int fd, std::vector<struct iovec>& parts)
+{
+    size_t done = 0;
+    while (done < parts.size())
+    {
+        int count = parts.size() - done < IOV_MAX ? (int)(parts.size() - done) : IOV_MAX;
+        ssize_t wrote = writev(fd, &parts[done], count);
+        if (wrote < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        // skip what went out, the last buffer may only be partly written
+        while (done < parts.size() && (size_t)wrote >= parts[done].iov_len)
+        {
+            wrote -= parts[done].iov_len;
+            done++;
+        }
+        if (wrote > 0)
+        {
+            parts[done].iov_base = (char*)parts[done].iov_base + wrote;
+            parts[done].iov_len -= wrote;
+        }
+    }
+    return true;
+}
+
+// one place in the reorder buffer, report num always lands in slot num % capacity
+struct ReorderSlot
+{
+    std::string report;
+    std::string trailer;    // written after the report only if another one follows
+    long long deliveredAt;  // statClock() when the report came in
+    std::atomic<bool> full; // set by the worker once report is in, cleared by the writer
+};
+
+// last stage of the pipeline: a reorder buffer the workers drop their reports into in whatever
+// order they finish, and a writer thread that prints every contiguous run of finished reports
+// in CPU order with a single writev. handing a report over is a swap and a couple of atomic
+// stores, so workers never wait for each other or for their turn. the mutex is only there for the writer or the reader to sleep on
+// when there is nothing to do, and reserve() keeps the reader from lapping the writer.
+struct OrderedWriter
+{
+    size_t capacity;
+    std::unique_ptr<ReorderSlot[]> slots;
+    std::atomic<long long> next;     // first report not written yet, numbers start at 1
+    std::atomic<long long> reserved; // last number handed to the reader
+    std::atomic<bool> closed;        // the reader is done
+    std::atomic<bool> writerAsleep;
+    std::atomic<bool> readerAsleep;
+    pthread_mutex_t mutex;
+    pthread_cond_t writerWakeup;
+    pthread_cond_t readerWakeup;
+    pthread_t thread;
+
+    OrderedWriter(size_t slotCount) : capacity(slotCount), slots(new ReorderSlot[slotCount]), next(1), reserved(0), closed(false), writerAsleep(false), readerAsleep(false)
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            slots[i].full = false;
+        }
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&writerWakeup, NULL);
+        pthread_cond_init(&readerWakeup, NULL);
+    }
+
+    ~OrderedWriter()
+    {
+        pthread_mutex_destroy(&mutex);
+        pthread_cond_destroy(&writerWakeup);
+        pthread_cond_destroy(&readerWakeup);
+    }
+
+    // sleeps on wakeup until done() holds. asleep is raised before the last check, and whoever
+    // makes done() true checks asleep after doing so, so one of the two always sees the other
+    template <typename Check>
+    void sleepUntil(std::atomic<bool>& asleep, pthread_cond_t& wakeup, Check done)
+    {
+        pthread_mutex_lock(&mutex);
+        asleep = true;
+        while (!done())
+        {
+            pthread_cond_wait(&wakeup, &mutex);
+        }
+        asleep = false;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    void wake(std::atomic<bool>& asleep, pthread_cond_t& wakeup)
+    {
+        if (asleep)
+        {
+            pthread_mutex_lock(&mutex);
+            pthread_cond_signal(&wakeup);
+            pthread_mutex_unlock(&mutex);
+        }
+    }
+
+    // reader side: waits for room and returns the number of the next report
+    long long reserve()
+    {
+        long long num = reserved + 1;
+        if (num - next >= (long long)capacity)
+        {
+            long long waitStart = statClock();
+            sleepUntil(readerAsleep, readerWakeup, [&]() { return num - next < (long long)capacity; });
+            statsWaited("reader", statClock() - waitStart);
+        }
+        reserved = num;
+        wake(writerAsleep, writerWakeup); // the writer may be waiting to know whether more is coming
+        return num;
+    }
+
+    // worker side: drops a finished report into its slot, never waits for its turn. report gets
+    // back whatever buffer the slot held last, empty but with its memory still there to reuse
+    void deliver(long long num, std::string& report, const std::string& trailer = "")
+    {
+        ReorderSlot& slot = slots[num % capacity];
+        slot.report.swap(report);
+        slot.trailer = trailer;
+        slot.deliveredAt = statClock();
+        slot.full = true;
+        wake(writerAsleep, writerWakeup);
+    }
+
+    // reader side: nothing else will be reserved
+    void close()
+    {
+        closed = true;
+        wake(writerAsleep, writerWakeup);
+    }
+
+    // the writer thread
+    void run()
+    {
+        std::vector<struct iovec> parts;
+        while (true)
+        {
+            long long first = next;
+            long long end = first;
+            while (end - first < (long long)capacity && slots[end % capacity].full)
+            {
+                end++;
+            }
+
+            if (end == first)
+            {
+                if (closed && first > reserved)
+                {
+                    break;
+                }
+                sleepUntil(writerAsleep, writerWakeup, [&]() { return slots[first % capacity].full || (closed && first > reserved); });
+                continue;
+            }
+
+            // the whole run of finished reports goes out in one writev. every trailer but the last
+            // one is known to be needed, the report after it is already here
+            parts.clear();
+            for (long long num = first; num < end; num++)
+            {
+                ReorderSlot& slot = slots[num % capacity];
+                parts.push_back({ (void*)slot.report.data(), slot.report.size() });
+                if (num + 1 < end && !slot.trailer.empty())
+                {
+                    parts.push_back({ (void*)slot.trailer.data(), slot.trailer.size() });
+                }
+            }
+            writeAll(STDOUT_FILENO, parts);
+
+            // hand every slot back before looking at the last trailer, the reader may have to get
+            // past them to tell us whether more is coming
+            std::string trailer;
+            long long printedAt = statClock();
+            for (long long num = first; num < end; num++)
+            {
+                ReorderSlot& slot = slots[num % capacity];
+                statsPrinted(num, printedAt - slot.deliveredAt);
+                if (num + 1 == end)
+                {
+                    trailer.swap(slot.trailer);
+                }
+                slot.report.clear();
+                if (slot.report.capacity() > KEEP_REPORT)
+                {
+                    std::string().swap(slot.report);
+                }
+                slot.full = false;
+            }
+            next = end;
+            wake(readerAsleep, readerWakeup);
+
+            if (!trailer.empty() && anotherAfter(end - 1))
+            {
+                parts.assign(1, { (void*)trailer.data(), trailer.size() });
+                writeAll(STDOUT_FILENO, parts);
+            }
+        }
+    }
+
+    // whether report num is followed by another one, waits for the reader if it can't tell yet
+    bool anotherAfter(long long num)
+    {
+        if (reserved > num || closed)
+        {
+            return reserved > num;
+        }
+
+        sleepUntil(writerAsleep, writerWakeup, [&]() { return reserved > num || closed; });
+        return reserved > num;
+    }
+
+    static void* writerThread(void* void_ptr)
+    {
+        ((OrderedWriter*)void_ptr)->run();
+        return NULL;
+    }
+
+    bool start()
+    {
+        return pthread_create(&thread, NULL, writerThread, this) == 0;
+    }
+
+    void join()
+    {
+        pthread_join(thread, NULL);
+    }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef READY_QUEUE_H
+#define READY_QUEUE_H
+
+#include <vector>
+#include <cstdint>
+#include "Stats.h"
+
+// rate monotonic priorities never change, so the ready queue only has to remember which
+// priority levels have work. bit k is set when the task ranked k is ready. a second level
+// of bits marks the words that are not empty, so finding the highest priority ready task
+// is a couple of count-trailing-zeros for any set up to 4096 tasks.
+struct ReadyBitmap
+{
+    std::vector<uint64_t> words;   // one bit per task
+    std::vector<uint64_t> summary; // one bit per non-empty word
+
+    void reset(size_t n)
+    {
+        words.assign((n + 63) / 64, 0);
+        summary.assign((words.size() + 63) / 64, 0);
+    }
+
+    void set(size_t k)
+    {
+        words[k / 64] |= uint64_t(1) << (k % 64);
+        summary[k / 4096] |= uint64_t(1) << ((k / 64) % 64);
+    }
+
+    void clear(size_t k)
+    {
+        words[k / 64] &= ~(uint64_t(1) << (k % 64));
+        if (words[k / 64] == 0)
+        {
+            summary[k / 4096] &= ~(uint64_t(1) << ((k / 64) % 64));
+        }
+    }
+
+    // highest priority ready task, or npos when everything is idle
+    size_t first() const
+    {
+        for (size_t s = 0; s < summary.size(); s++)
+        {
+            if (summary[s])
+            {
+                size_t w = s * 64 + __builtin_ctzll(summary[s]);
+                return w * 64 + __builtin_ctzll(words[w]);
+            }
+        }
+        return npos;
+    }
+
+    static constexpr size_t npos = (size_t)-1;
+};
+
+// min-heap of the next release time of every task, indexed by task so a task's entry can be
+// pushed back in place once its job is released. ties go to the lower task number.
+struct ReleaseCalendar
+{
+    std::vector<long long> when; // next release of each task
+    std::vector<int> heap;       // task numbers ordered by release time
+    std::vector<int> slot;       // where each task sits in heap, -1 if it never releases
+
+    void reset(size_t n)
+    {
+        when.assign(n, 0);
+        slot.assign(n, -1);
+        heap.clear();
+        heap.reserve(n);
+    }
+
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    int top() const
+    {
+        return heap[0];
+    }
+
+    long long nextTime() const
+    {
+        return when[heap[0]];
+    }
+
+    void add(int task, long long time)
+    {
+        when[task] = time;
+        slot[task] = (int)heap.size();
+        heap.push_back(task);
+        siftUp(heap.size() - 1);
+    }
+
+    // move the earliest task to its following release
+    void advanceTop(long long time)
+    {
+        when[heap[0]] = time;
+        siftDown(0);
+    }
+
+    bool before(int a, int b) const
+    {
+        if (when[a] == when[b])
+            return a < b;
+
+        return when[a] < when[b];
+    }
+
+    void place(size_t i, int task)
+    {
+        heap[i] = task;
+        slot[task] = (int)i;
+    }
+
+    void siftUp(size_t i)
+    {
+        countHeapOp();
+        int task = heap[i];
+        while (i > 0 && before(task, heap[(i - 1) / 2]))
+        {
+            place(i, heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, task);
+    }
+
+    void siftDown(size_t i)
+    {
+        countHeapOp();
+        int task = heap[i];
+        size_t n = heap.size();
+        while (2 * i + 1 < n)
+        {
+            size_t child = 2 * i + 1;
+            if (child + 1 < n && before(heap[child + 1], heap[child]))
+            {
+                child++;
+            }
+            if (!before(heap[child], task))
+            {
+                break;
+            }
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, task);
+    }
+};
+
+#endif
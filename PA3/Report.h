@@ -0,0 +1,97 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <string_view>
+#include <vector>
+#include "Scheduler.h"
+#include "Format.h"
+
+// the pieces of the text report RMSA prints for a set, shared with Convert.cpp so a binary result
+// turns into exactly the text PA3 would have printed, and with PA3-OS.cpp for the response times
+// and the diagram, which it prints the same way. tasks are handed over by an accessor,
+// taskAt(k) giving the ReportTask of task k, so no caller has to copy its tasks into a list first
+
+struct ReportTask
+{
+    std::string_view name;
+    int wcet;
+    int period;
+};
+
+// CPU n, the tasks in the order they were given, the utilization and the hyperperiod
+template <typename TaskAt>
+void writeSetInfo(ReportBuffer& out, int cpu, size_t count, TaskAt taskAt, double util, long long hyperPeriod)
+{
+    out << "CPU " << cpu << "\n";
+    out << "Task scheduling information: ";
+    for (size_t k = 0; k < count; k++)
+    {
+        ReportTask task = taskAt(k);
+        out << task.name << " (WCET: " << task.wcet << ", Period: " << task.period;
+        out << (k + 1 < count ? "), " : ") "); // a comma unless it's the last one
+    }
+
+    out << "\nTask set utilization: " << Fixed{ util, 2 };
+    if (hyperPeriod == HYPERPERIOD_OVERFLOW)
+    {
+        out << "\nHyperperiod: too large for 64 bits\n";
+    }
+    else
+    {
+        out << "\nHyperperiod: " << hyperPeriod << "\n";
+    }
+}
+
+// the response time test, rankedAt(k) being the k-th task in rate monotonic order
+template <typename TaskAt>
+void writeResponses(ReportBuffer& out, size_t count, TaskAt rankedAt, const std::vector<long long>& responses)
+{
+    out << "Worst case response times: ";
+    for (size_t k = 0; k < count; k++)
+    {
+        ReportTask task = rankedAt(k);
+        out << task.name << " (R: ";
+        if (responses[k] > task.period)
+        {
+            out << ">" << task.period; // missed, it stopped counting here
+        }
+        else
+        {
+            out << responses[k];
+        }
+        out << (k + 1 < count ? "), " : ")");
+    }
+    out << "\n";
+}
+
+// the line the diagram goes on, up to where it starts
+inline void writeDiagramHead(ReportBuffer& out, int cpu, long long window, long long hyperPeriod)
+{
+    out << "Scheduling Diagram for CPU " << cpu;
+    if (window != hyperPeriod)
+    {
+        out << " (level-1 busy period, first " << window << " time units)";
+    }
+    out << ": ";
+}
+
+// the diagram, nameOf(k) being the name of the k-th task in rate monotonic order
+template <typename NameOf>
+void writeDiagram(ReportBuffer& out, const std::vector<Segment>& segments, NameOf nameOf)
+{
+    DiagramWriter diagram(out);
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        if (segments[i].task == IDLE)
+        {
+            diagram.addIdle(segments[i].length);
+        }
+        else
+        {
+            diagram.add(nameOf(segments[i].task), segments[i].length);
+        }
+    }
+    diagram.finish();
+}
+
+#endif
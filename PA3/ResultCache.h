@@ -0,0 +1,133 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <pthread.h>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Scheduler.h"
+#include "Analysis.h"
+
+// how much memory the results of sets seen before may take, unless --cache-size says otherwise
+const long long DEFAULT_CACHE_SIZE = 64 << 20;
+
+// the cache keeps a set's whole analysis, which doesn't depend on what its tasks are called or
+// what order they came in
+typedef SetResult CachedResult;
+
+// builds the key of a task set: the (wcet, period) of every task in rate monotonic order, which
+// is the same for any order the tasks are given in. tasks with the same period are ranked by
+// name, so that much of the naming is part of the key on its own. with remapping off the names
+// are added too and a hit has to match them exactly
+struct CacheKey
+{
+    std::string bytes;
+
+    void clear()
+    {
+        bytes.clear();
+    }
+
+    void add(long long value)
+    {
+        bytes.append((const char*)&value, sizeof(value));
+    }
+
+    void add(std::string_view name)
+    {
+        add((long long)name.size());
+        bytes.append(name.data(), name.size());
+    }
+};
+
+// results of task sets seen before, shared by all the workers. least recently used entries go
+// first once the entries take more than maxBytes. an entry is never changed after it is put in,
+// so a worker keeps using the one it got even if it gets evicted in the meantime
+struct ResultCache
+{
+    typedef std::shared_ptr<const CachedResult> Entry;
+    typedef std::list<std::pair<std::string, Entry>> Order; // most recently used first
+
+    size_t maxBytes;
+    bool remapNames;  // a hit may come from a set with other task names
+    Order order;
+    std::unordered_map<std::string, Order::iterator> index;
+    size_t usedBytes = 0;
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+    pthread_mutex_t mutex;
+
+    ResultCache(size_t maxBytes, bool remapNames) : maxBytes(maxBytes), remapNames(remapNames)
+    {
+        pthread_mutex_init(&mutex, NULL);
+    }
+
+    ~ResultCache()
+    {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // the entry for key, or NULL
+    Entry find(const CacheKey& key)
+    {
+        pthread_mutex_lock(&mutex);
+        Entry found;
+        std::unordered_map<std::string, Order::iterator>::iterator it = index.find(key.bytes);
+        if (it != index.end())
+        {
+            order.splice(order.begin(), order, it->second);
+            found = it->second->second;
+            hits++;
+        }
+        else
+        {
+            misses++;
+        }
+        pthread_mutex_unlock(&mutex);
+        return found;
+    }
+
+    // keeps result for key. an entry that would take more than a quarter of the cache isn't
+    // kept, one long hyperperiod shouldn't push out everything else
+    void insert(const CacheKey& key, const Entry& result)
+    {
+        size_t bytes = result->bytes() + 2 * key.bytes.size();
+        if (bytes > maxBytes / 4)
+        {
+            return;
+        }
+
+        pthread_mutex_lock(&mutex);
+        if (index.find(key.bytes) == index.end()) // another worker may have just put the same set in
+        {
+            order.emplace_front(key.bytes, result);
+            index[key.bytes] = order.begin();
+            usedBytes += bytes;
+
+            while (usedBytes > maxBytes)
+            {
+                usedBytes -= order.back().second->bytes() + 2 * order.back().first.size();
+                index.erase(order.back().first);
+                order.pop_back();
+                evictions++;
+            }
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    void writeCounters(FILE* file)
+    {
+        pthread_mutex_lock(&mutex);
+        fprintf(file, "cache: %lld hits, %lld misses, %lld evictions, %zu entries, %zu bytes\n",
+            hits, misses, evictions, order.size(), usedBytes);
+        pthread_mutex_unlock(&mutex);
+    }
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef RMS_H
+#define RMS_H
+
+#include <iostream>
+#include <unistd.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string>
+#include <numeric>
+#include <queue>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include "Scheduler.h"
+#include "Pipeline.h"
+#include "Input.h"
+#include "Format.h"
+#include "Stats.h"
+#include "TaskTable.h"
+#include "Analysis.h"
+#include "Edf.h"
+#include "Binary.h"
+#include "Report.h"
+
+// what PA3-OS runs on every set: readSet parses it and RMS (or EDF for --policy edf) writes its
+// report. PA3-OS.cpp runs them on its worker threads, Benchmark.cpp calls them one set at a time
+
+// a plain record, the name lives in the set's NameTable so any number of tasks can have a name of any length
+struct Task
+{
+    uint32_t id;    // id of the task name in Info::names
+    int wcet;
+    int period;
+    uint64_t key;   // rate monotonic priority from priorityKey, smaller runs first
+};
+
+struct Info
+{
+    std::vector<Task> tasks;
+    NameTable names;       // every task name of the set, stored once
+    int CPUnum;
+    double utilization;
+    long long hyperPeriod;
+    long long windowLimit; // longest hyperperiod simulated in full
+    double setNum;
+    ReportBuffer* report;  // where the report for this set gets written
+    InputLine line;        // the set as read, parsed by the worker
+    bool binary;           // line is a set record (Binary.h) instead of text
+    bool binaryOut;        // --output-format binary: a result record instead of the text report
+    Algorithm algorithm;   // --policy: rate monotonic or EDF
+};
+
+// calculates utilization for each set of tasks
+inline double setUtilization(const std::vector<Task>& tasks)
+{
+    double util = 0;
+    // gets the sum of WCET / period
+    for (const auto& task : tasks)
+    {
+        util += float(task.wcet) / task.period;
+    }
+    return util;
+}
+
+// sorts the vector of tasks based on the period in ascending order
+inline bool tasksPriority(const Task a, const Task b)
+{
+    return a.period < b.period;
+}
+
+// what the CPU loop prints for one set before the algorithm's output, the "\n\n\n" between sets is left to the writer
+inline void printReport(const Info& info)
+{
+    ReportBuffer& report = *info.report;
+    report << "CPU " << info.CPUnum << "\n";
+    // output task information
+    report << "Task scheduling information: ";
+    for (size_t j = 0; j < info.tasks.size(); j++)
+    {
+        if (j < info.tasks.size() - 1)
+        {
+            report << info.names.get(info.tasks.at(j).id) << " (WCET: " << info.tasks.at(j).wcet << ", Period: " << info.tasks.at(j).period << "), ";
+        }
+        else
+        {
+            report << info.names.get(info.tasks.at(j).id) << " (WCET: " << info.tasks.at(j).wcet << ", Period: " << info.tasks.at(j).period << ")\n";
+
+            report << "Task set utilization: " << Fixed{ info.utilization, 2 } << "\n";
+            if (info.hyperPeriod == HYPERPERIOD_OVERFLOW)
+            {
+                report << "Hyperperiod: too large for 64 bits\n";
+            }
+            else
+            {
+                report << "Hyperperiod: " << info.hyperPeriod << "\n";
+            }
+            report << (info.algorithm == EARLIEST_DEADLINE_FIRST ? "Earliest Deadline First" : "Rate Monotonic Algorithm") << " execution for CPU" << info.CPUnum << ": \n";
+        }
+    }
+}
+
+// rate monotonic ranking (shorter period first, then by name), one compare of the precomputed keys
+inline bool compareTasks(const Task& a, const Task& b)
+{
+    return a.key < b.key;
+}
+
+// the tasks in rate monotonic order, and the same as the simulators take them
+inline void rankTasks(const std::vector<Task>& tasks, std::vector<Task>& ranked, std::vector<SimTask>& simTasks)
+{
+    ranked = tasks;
+    std::stable_sort(ranked.begin(), ranked.end(), compareTasks);
+    for (size_t i = 0; i < ranked.size(); i++)
+    {
+        simTasks.push_back({ ranked.at(i).wcet, ranked.at(i).period });
+    }
+}
+
+// the set as a binary result record (Binary.h), the same record PA3 writes for it
+inline void writeResult(std::string& out, const Info& info, bool overloaded, bool needsExact, const SetResult& result)
+{
+    // every task's place in rate monotonic order, the same stable sort that ranked them
+    std::vector<uint32_t> order(info.tasks.size()), rank(info.tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return compareTasks(info.tasks[a], info.tasks[b]); });
+    for (size_t r = 0; r < order.size(); r++)
+    {
+        rank[order[r]] = (uint32_t)r;
+    }
+
+    size_t start = startResult(out, info.CPUnum, resultVerdict(overloaded, needsExact, result.schedulable), info.utilization, result.hyperPeriod, result.window, info.tasks.size());
+    for (size_t k = 0; k < info.tasks.size(); k++)
+    {
+        const Task& task = info.tasks[k];
+        putResultTask(out, info.names.get(task.id), task.wcet, task.period, rank[k], result.responses.empty() ? -1 : result.responses[rank[k]]);
+    }
+    finishResult(out, start, result.segments);
+}
+
+inline void* RMS(void* void_ptr)
+{
+    // cast void pointer to a struct of type Info
+    Info* infoPtr = (Info*)void_ptr;
+
+    // calculate the utilization for the set of tasks
+    infoPtr->utilization = setUtilization(infoPtr->tasks);
+    // calculate the hyperperiod for the set of tasks
+    infoPtr->hyperPeriod = setHyperPeriod(infoPtr->tasks);
+
+    // check if the tasks are schedulable
+    infoPtr->setNum = liuLaylandBound(infoPtr->tasks.size());
+
+    // an empty set only gets the first two lines
+    if (!infoPtr->binaryOut)
+    {
+        printReport(*infoPtr);
+        if (infoPtr->tasks.empty())
+        {
+            return NULL;
+        }
+    }
+    ReportBuffer& out = *infoPtr->report;
+
+    // the simulator and the response time test want the tasks in priority order
+    std::vector<Task> ranked;
+    std::vector<SimTask> simTasks;
+    rankTasks(infoPtr->tasks, ranked, simTasks);
+
+    // the response time test if the bound can't tell, and the window to simulate
+    SetResult result;
+    bool overloaded = infoPtr->utilization > 1;
+    bool needsExact = !infoPtr->tasks.empty() && !(infoPtr->utilization <= infoPtr->setNum); // an empty set's bound is nan
+    decideSet(simTasks, overloaded, needsExact, infoPtr->hyperPeriod, infoPtr->windowLimit, result);
+
+    if (infoPtr->binaryOut)
+    {
+        if (result.schedulable)
+        {
+            simulateSet(simTasks, result);
+        }
+        writeResult(out.text, *infoPtr, overloaded, needsExact, result);
+        return NULL;
+    }
+
+    if (overloaded)
+    {
+        out << "The task set is not schedulable";
+    }
+    else if (needsExact)
+    {
+        writeResponses(out, ranked.size(), [&](size_t k) { return ReportTask{ infoPtr->names.get(ranked[k].id), ranked[k].wcet, ranked[k].period }; }, result.responses);
+        if (!result.schedulable)
+        {
+            out << "The task set is not schedulable";
+        }
+    }
+
+    if (result.schedulable)
+    {
+        // execute algorithm, only the level-1 busy period if the hyperperiod is too long
+        writeDiagramHead(out, infoPtr->CPUnum, result.window, infoPtr->hyperPeriod);
+
+        // jump between releases and completions instead of going tick by tick
+        simulateSet(simTasks, result);
+        writeDiagram(out, result.segments, [&](int k) { return infoPtr->names.get(ranked[k].id); });
+    }
+
+    return NULL;
+}
+
+// RMS for --policy edf: the exact QPA demand test decides it and the diagram is the EDF schedule
+inline void* EDF(void* void_ptr)
+{
+    Info* infoPtr = (Info*)void_ptr;
+    infoPtr->utilization = setUtilization(infoPtr->tasks);
+    infoPtr->hyperPeriod = setHyperPeriod(infoPtr->tasks);
+
+    printReport(*infoPtr);
+    if (infoPtr->tasks.empty())
+    {
+        return NULL;
+    }
+    ReportBuffer& out = *infoPtr->report;
+
+    // rate monotonic order only decides what the task numbers in the diagram refer to
+    std::vector<Task> ranked;
+    std::vector<SimTask> simTasks;
+    rankTasks(infoPtr->tasks, ranked, simTasks);
+
+    SetResult result;
+    decideEdfSet(simTasks, infoPtr->hyperPeriod, infoPtr->windowLimit, result);
+    if (!result.schedulable)
+    {
+        out << "The task set is not schedulable";
+        return NULL;
+    }
+
+    writeDiagramHead(out, infoPtr->CPUnum, result.window, infoPtr->hyperPeriod);
+    simulateEdfSet(simTasks, result);
+    writeDiagram(out, result.segments, [&](int k) { return infoPtr->names.get(ranked[k].id); });
+    return NULL;
+}
+
+// parses the set straight out of the read buffer and lets go of it. a name is any word, not just one letter
+inline void readSet(Info* info)
+{
+    TaskCursor fields(info->line.text, info->binary);
+    std::string_view name;
+    Task tempTask;
+    while (fields.next(name, tempTask.wcet, tempTask.period))
+    {
+        tempTask.id = info->names.intern(name);
+        info->tasks.push_back(tempTask);
+    }
+    info->line = InputLine();
+
+    std::vector<uint32_t> ranks;
+    info->names.rank(ranks);
+    for (size_t k = 0; k < info->tasks.size(); k++)
+    {
+        info->tasks[k].key = priorityKey(info->tasks[k].period, ranks[info->tasks[k].id]);
+    }
+}
+
+#endif
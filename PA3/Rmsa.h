@@ -0,0 +1,638 @@
+#ifndef RMSA_H
+#define RMSA_H
+
+#include <pthread.h>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <queue>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include "Scheduler.h"
+#include "WorkStealing.h"
+#include "Pipeline.h"
+#include "Input.h"
+#include "Format.h"
+#include "Stats.h"
+#include "TaskTable.h"
+#include "ResultCache.h"
+#include "Partition.h"
+#include "GlobalSchedule.h"
+#include "Edf.h"
+#include "Analysis.h"
+#include "Server.h"
+#include "Binary.h"
+#include "Report.h"
+
+// the analysis PA3 runs on every line: RMSA for rate monotonic on one cpu, EDFA for --policy edf,
+// globalRMSA for --global and runPartition for --partition, with runRMSA picking between the first
+// three. PA3.cpp reads the input and hands the lines to them on its pool, Benchmark.cpp calls them
+// one set at a time
+
+struct args
+{
+    InputLine in;                         // input, still sitting in the read buffer
+    int num;                              // which call it is, the report's place in the output
+    int cpu;                              // the CPU number the report shows
+    long long windowLimit;                // longest hyperperiod simulated in full
+    OrderedWriter* writer;                // prints the reports in CPU order
+    std::shared_ptr<Connection> reply;    // --serve: the client the report goes back to instead of the writer
+    bool binaryIn;                        // --input-format binary: in is a set record (Binary.h), not a line
+    bool binaryOut;                       // --output-format binary: a result record instead of the text report
+    StealingPool* pool;                   // where long simulations get split up, NULL to never split
+    ResultCache* cache;                   // results of sets seen before, NULL to not cache
+    int cores;                            // more than 0: global scheduling on that many cores (--global)
+    Algorithm algorithm;                  // --policy: rate monotonic or EDF, on one cpu or with cores
+};
+
+// node will be the main struct used for each task, a plain record: the name lives in the set's NameTable
+struct node
+{
+    uint32_t name;    // id of the task name in the set's NameTable
+    int wceTime;      // stores the task worst case execution time
+    int period;       // stores the task period
+    uint64_t key;     // rate monotonic priority from priorityKey, smaller runs first
+};
+
+// static rate monotonic ranking (shorter period first, then by name), one compare of the precomputed keys
+inline bool higherPriority(const node& a, const node& b)
+{
+    return a.key < b.key;
+}
+
+// works out every task's key once all the names of the set are in
+inline void setPriorityKeys(std::vector<node>& tasks, const NameTable& names)
+{
+    std::vector<uint32_t> ranks;
+    names.rank(ranks);
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        tasks[k].key = priorityKey(tasks[k].period, ranks[tasks[k].name]);
+    }
+}
+
+// this function takes the segments the simulator produced and writes them out formatted.
+inline void convertToTaskSchedule(ReportBuffer& out, const std::vector<Segment>& segments, const std::vector<node>& ranked, const NameTable& names)
+{
+    writeDiagram(out, segments, [&](int k) { return names.get(ranked[k].name); });
+}
+
+// the binary result record of a set (Binary.h) up to its segments, finishReport adds those. it
+// starts the report, so finishReport knows it is at 0
+inline void writeResultHead(std::string& out, int cpu, const std::vector<node>& tasks, const NameTable& names, double util, bool overloaded, bool needsExact, const CachedResult& result)
+{
+    // where every task ended up in rate monotonic order, the same stable sort that made ranked
+    std::vector<uint32_t> order(tasks.size()), rank(tasks.size());
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        order[k] = (uint32_t)k;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return higherPriority(tasks[a], tasks[b]); });
+    for (size_t r = 0; r < order.size(); r++)
+    {
+        rank[order[r]] = (uint32_t)r;
+    }
+
+    startResult(out, cpu, resultVerdict(overloaded, needsExact, result.schedulable), util, result.hyperPeriod, result.window, tasks.size());
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        putResultTask(out, names.get(tasks[k].name), tasks[k].wceTime, tasks[k].period, rank[k], result.responses.empty() ? -1 : result.responses[rank[k]]);
+    }
+}
+
+// the key the cache knows a set under: how the utilization decided it, the window limit and the
+// ranked tasks. names only go in when a hit has to match them
+inline void resultKey(CacheKey& key, const std::vector<node>& ranked, const NameTable& names, bool overloaded, bool needsExact, long long windowLimit, bool remapNames)
+{
+    key.clear();
+    key.add((long long)overloaded << 1 | needsExact);
+    key.add(windowLimit);
+    for (size_t k = 0; k < ranked.size(); k++)
+    {
+        key.add(ranked[k].wceTime);
+        key.add(ranked[k].period);
+        if (!remapNames)
+        {
+            key.add(names.get(ranked[k].name));
+        }
+    }
+}
+
+// hands a report to the writer stage, or with --serve back to the client that sent the set.
+// nobody waits here for their turn to print
+inline void sendReport(const args& Boat, std::string& report)
+{
+    if (Boat.reply)
+    {
+        Boat.reply->deliver(Boat.num, report);
+    }
+    else
+    {
+        Boat.writer->deliver(Boat.num, report); // swaps in a spare buffer from the writer, no copy
+    }
+}
+
+// finishes the report with the diagram and sends it
+inline void finishReport(const args& Boat, ReportBuffer& out, const std::vector<node>& ranked, const NameTable& names, const std::vector<Segment>& segments, SetProbe& probe)
+{
+    if (Boat.binaryOut)
+    {
+        finishResult(out.text, 0, segments);
+    }
+    else
+    {
+        convertToTaskSchedule(out, segments, ranked, names);
+        out << "\n\n";
+    }
+
+    probe.analyzed();
+    probe.record(Boat.num, out.text.size());
+
+    sendReport(Boat, out.text);
+}
+
+// simulations shorter than this are never split, finding where a piece starts has to pay off
+const long long MIN_PIECE = 1 << 20;
+
+// how many stealable pieces a window of the schedule is worth. every piece after the first looks
+// back one busy period for the idle instant it starts at, or re-simulates that busy period when
+// the set can't be cut at idle instants, so pieces have to be much longer than that
+inline int splitCount(long long window, long long busy, bool idleCuts, int workers)
+{
+    if (workers < 2 || busy >= window)
+    {
+        return 1;
+    }
+
+    long long piece = std::max(MIN_PIECE, (idleCuts ? 2 : 8) * busy);
+    return (int)std::min<long long>(window / piece, 4 * workers);
+}
+
+// one long simulation cut into pieces, the last piece to finish puts the diagram together
+struct splitRun
+{
+    args Boat;
+    ReportBuffer out;              // report up to the diagram
+    std::vector<node> ranked;
+    NameTable names;
+    std::vector<SimTask> simTasks;
+    long long window;              // how much of the timeline is drawn
+    long long busy;                // level-1 busy period, the longest anything carries over between pieces
+    bool idleCuts;                 // pieces start at idle instants instead of warming up
+    std::vector<std::vector<Segment>> pieces;
+    std::shared_ptr<CachedResult> result; // gets the whole schedule, then goes into the cache
+    CacheKey key;
+    int left;                      // pieces still running
+    SetProbe probe;                // what the set cost, every piece adds its share
+    pthread_mutex_t mutex;         // for left and probe
+};
+
+struct splitPiece
+{
+    splitRun* run;
+    int index;
+};
+
+inline void runPiece(void* arg)
+{
+    splitPiece* piece = (splitPiece*)arg;
+    splitRun* run = piece->run;
+    long long pieces = (long long)run->pieces.size();
+    long long from = run->window / pieces * piece->index;
+    long long to = piece->index + 1 == pieces ? run->window : from + run->window / pieces;
+
+    SetProbe share;
+    share.start();
+
+    // moved up to the next idle instant nothing is left over from the piece before, so there is
+    // nothing to warm up. the piece after works out the same instant for its start, the pieces
+    // still meet without waiting on each other
+    long long warmup = warmupStart(from, run->busy);
+    if (run->idleCuts)
+    {
+        from = warmup = idleInstant(run->simTasks, from, run->busy, run->window);
+        to = to < run->window ? idleInstant(run->simTasks, to, run->busy, run->window) : to;
+    }
+
+    std::vector<Segment> segments;
+    simulateRMSBetween(run->simTasks, warmup, from, to, [&](int task, long long start, long long length)
+    {
+        addSegment(segments, task, start, length);
+    });
+    run->pieces[piece->index].swap(segments);
+    delete piece;
+
+    share.analyzed();
+    pthread_mutex_lock(&run->mutex);
+    run->probe.merge(share);
+    bool last = --run->left == 0;
+    pthread_mutex_unlock(&run->mutex);
+
+    if (last)
+    {
+        run->probe.start(); // putting the diagram together is on this thread
+        std::vector<Segment>& segments = run->result->segments;
+        for (size_t i = 0; i < run->pieces.size(); i++)
+        {
+            for (size_t j = 0; j < run->pieces[i].size(); j++)
+            {
+                addSegment(segments, run->pieces[i][j].task, run->pieces[i][j].start, run->pieces[i][j].length);
+            }
+            std::vector<Segment>().swap(run->pieces[i]);
+        }
+        if (run->Boat.cache)
+        {
+            run->Boat.cache->insert(run->key, run->result);
+        }
+        finishReport(run->Boat, run->out, run->ranked, run->names, segments, run->probe);
+
+        pthread_mutex_destroy(&run->mutex);
+        delete run;
+    }
+}
+
+// here is my function used in multi-threading
+inline void* RMSA(void* x_void_ptr) // RMSA --> Rate Monotonic Scheduling Algorithm
+{
+    args Boat = *(args*)x_void_ptr; // Deinitilization
+    int localNum = Boat.cpu;         // turning shared resource into a local resource
+    SetProbe probe;                  // performance counters, nothing unless built with PA3_STATS
+    probe.start();
+
+    std::vector<node> Ttasks;
+    NameTable names;                                // every task name of the set, stored once
+    TaskCursor fields(Boat.in.text, Boat.binaryIn); // reads the line (or record) in place
+
+    // initializing variables
+    std::string_view name;
+    int wceTime, period;
+    int numTasks = 0;
+    double util = 0;
+    ReportBuffer& out = workerBuffer(); // reused from the last report this worker wrote
+    out.clear();
+
+    // keeping the tasks in input order, the simulator ranks its own copy
+    while (fields.next(name, wceTime, period))
+    {
+        Ttasks.push_back({ names.intern(name), wceTime, period, 0 });
+    }
+    setPriorityKeys(Ttasks, names);
+    Boat.in = InputLine(); // done with the line, let go of the buffer
+    probe.parsed();
+
+    // the simulator and the response time test want the tasks in priority order
+    std::vector<node> ranked = Ttasks;
+    std::stable_sort(ranked.begin(), ranked.end(), higherPriority);
+
+    std::vector<SimTask> simTasks;
+    for (size_t k = 0; k < ranked.size(); k++)
+    {
+        simTasks.push_back({ ranked[k].wceTime, ranked[k].period });
+    }
+
+    // this for-loop gets the utilization number
+    for (std::vector<node>::const_iterator it = Ttasks.begin(); it != Ttasks.end(); ++it)
+    {
+        const node& task = *it;
+        numTasks++;
+        util = util + (static_cast<double>(task.wceTime) / static_cast<double>(task.period));
+    }
+
+    // logic based on utilization and formula given in directions
+    bool overloaded = util > 1;
+    bool needsExact = !overloaded && util > liuLaylandBound(numTasks); // the bound can't decide it
+
+    // a set seen before (in any order, under any names if the cache remaps them) skips the
+    // hyperperiod, the response time test and the simulation. a new one is worked out into fresh
+    CacheKey key;
+    ResultCache::Entry known;
+    if (Boat.cache)
+    {
+        resultKey(key, ranked, names, overloaded, needsExact, Boat.windowLimit, Boat.cache->remapNames);
+        known = Boat.cache->find(key);
+    }
+    std::shared_ptr<CachedResult> fresh;
+    if (!known)
+    {
+        fresh = std::make_shared<CachedResult>();
+        decideSet(simTasks, overloaded, needsExact, setHyperPeriod(Ttasks), Boat.windowLimit, *fresh);
+    }
+    const CachedResult& result = known ? *known : *fresh;
+    long long hyperPeriod = result.hyperPeriod;
+    bool schedulable = result.schedulable;
+
+    // printing, or everything but the schedule as one binary record
+    if (Boat.binaryOut)
+    {
+        writeResultHead(out.text, localNum, Ttasks, names, util, overloaded, needsExact, result);
+    }
+    else
+    {
+        writeSetInfo(out, localNum, Ttasks.size(), [&](size_t k) { return ReportTask{ names.get(Ttasks[k].name), Ttasks[k].wceTime, Ttasks[k].period }; }, util, hyperPeriod);
+        out << "Rate Monotonic Algorithm execution for CPU " << localNum << ":\n";
+
+        if (overloaded)
+        {
+            out << "The task set is not schedulable\n";
+        }
+        else if (needsExact)
+        {
+            // the bound couldn't decide this set, so the exact response time test did
+            writeResponses(out, ranked.size(), [&](size_t k) { return ReportTask{ names.get(ranked[k].name), ranked[k].wceTime, ranked[k].period }; }, result.responses);
+            if (!schedulable)
+            {
+                out << "The task set is not schedulable\n";
+            }
+        }
+
+        if (schedulable)
+        {
+            // a hyperperiod that is too long only gets its level-1 busy period drawn
+            writeDiagramHead(out, localNum, result.window, hyperPeriod);
+        }
+    }
+
+    if (schedulable) // find the scheduling diagram
+    {
+        long long window = result.window;
+        if (known)
+        {
+            finishReport(Boat, out, ranked, names, known->segments, probe);
+            return NULL;
+        }
+
+        // a really long simulation gets cut up so idle workers can steal the pieces
+        long long busy = busyPeriod(simTasks, window);
+        bool idleCuts = regularReleases(simTasks);
+        int pieces = Boat.pool ? splitCount(window, busy, idleCuts, Boat.pool->size()) : 1;
+        if (pieces > 1)
+        {
+            splitRun* run = new splitRun;
+            run->Boat = Boat;
+            run->out = out;
+            run->ranked = ranked;
+            run->names = names;
+            run->simTasks = simTasks;
+            run->window = window;
+            run->busy = busy;
+            run->idleCuts = idleCuts;
+            run->pieces.resize(pieces);
+            run->result = fresh;
+            run->key = key;
+            run->left = pieces;
+            probe.analyzed();
+            run->probe = probe;
+            pthread_mutex_init(&run->mutex, NULL);
+
+            // pushed to the front of our own deque backwards so we start on piece 0 ourselves
+            for (int i = pieces - 1; i >= 0; i--)
+            {
+                splitPiece* piece = new splitPiece;
+                piece->run = run;
+                piece->index = i;
+                Boat.pool->push(StealingPool::currentWorker(), { runPiece, piece }, true);
+            }
+            return NULL; // the last piece to finish prints the report
+        }
+
+        // jump from release to completion instead of ticking through the hyperperiod
+        simulateSet(simTasks, *fresh);
+    }
+
+    if (fresh && Boat.cache)
+    {
+        Boat.cache->insert(key, fresh);
+    }
+    finishReport(Boat, out, ranked, names, result.segments, probe);
+    return NULL;
+}
+
+// a set read for one of the other modes than plain RMSA
+struct parsedSet
+{
+    std::vector<node> tasks;       // input order
+    std::vector<node> ranked;      // rate monotonic order
+    std::vector<SimTask> simTasks; // ranked, the way the simulators want them
+    NameTable names;
+    double util;
+    long long hyperPeriod;
+};
+
+// parses Boat's line and writes the start of the report every mode shares, up to the hyperperiod
+inline void readSetHeader(args& Boat, parsedSet& set, ReportBuffer& out, SetProbe& probe)
+{
+    TaskCursor fields(Boat.in.text, Boat.binaryIn);
+    std::string_view name;
+    int wceTime, period;
+    while (fields.next(name, wceTime, period))
+    {
+        set.tasks.push_back({ set.names.intern(name), wceTime, period, 0 });
+    }
+    setPriorityKeys(set.tasks, set.names);
+    Boat.in = InputLine();
+    probe.parsed();
+
+    set.util = 0;
+    for (size_t k = 0; k < set.tasks.size(); k++)
+    {
+        set.util = set.util + (static_cast<double>(set.tasks[k].wceTime) / static_cast<double>(set.tasks[k].period));
+    }
+    set.hyperPeriod = setHyperPeriod(set.tasks);
+    writeSetInfo(out, Boat.cpu, set.tasks.size(), [&](size_t k) { return ReportTask{ set.names.get(set.tasks[k].name), set.tasks[k].wceTime, set.tasks[k].period }; }, set.util, set.hyperPeriod);
+
+    set.ranked = set.tasks;
+    std::stable_sort(set.ranked.begin(), set.ranked.end(), higherPriority);
+    for (size_t k = 0; k < set.ranked.size(); k++)
+    {
+        set.simTasks.push_back({ set.ranked[k].wceTime, set.ranked[k].period });
+    }
+}
+
+// records and hands over a report that is done
+inline void deliverReport(const args& Boat, ReportBuffer& out, SetProbe& probe)
+{
+    probe.analyzed();
+    probe.record(Boat.num, out.text.size());
+    sendReport(Boat, out.text);
+}
+
+// RMSA for --policy edf: the exact QPA demand test instead of the bound and the response times,
+// and the diagram of the EDF schedule
+inline void* EDFA(void* x_void_ptr)
+{
+    args Boat = *(args*)x_void_ptr;
+    SetProbe probe;
+    probe.start();
+    ReportBuffer& out = workerBuffer();
+    out.clear();
+    parsedSet set;
+    readSetHeader(Boat, set, out, probe);
+    out << "Earliest Deadline First execution for CPU " << Boat.cpu << ":\n";
+
+    SetResult result;
+    decideEdfSet(set.simTasks, set.hyperPeriod, Boat.windowLimit, result);
+    if (!result.schedulable)
+    {
+        out << "The task set is not schedulable\n\n";
+        deliverReport(Boat, out, probe);
+        return NULL;
+    }
+
+    writeDiagramHead(out, Boat.cpu, result.window, set.hyperPeriod);
+    simulateEdfSet(set.simTasks, result);
+    convertToTaskSchedule(out, result.segments, set.ranked, set.names);
+    out << "\n\n";
+    deliverReport(Boat, out, probe);
+    return NULL;
+}
+
+// the --global version of RMSA: one set on Boat.cores cores sharing a ready queue, every core's
+// diagram, and how often jobs got preempted, migrated and missed their deadline
+inline void* globalRMSA(void* x_void_ptr)
+{
+    args Boat = *(args*)x_void_ptr;
+    SetProbe probe;
+    probe.start();
+    ReportBuffer& out = workerBuffer();
+    out.clear();
+    parsedSet set;
+    readSetHeader(Boat, set, out, probe);
+    out << "Global " << (Boat.algorithm == EARLIEST_DEADLINE_FIRST ? "EDF" : "Rate Monotonic") << " execution for CPU " << Boat.cpu << " on " << Boat.cores << " cores:\n";
+
+    if (set.util > Boat.cores)
+    {
+        out << "The task set is not schedulable\n\n";
+        deliverReport(Boat, out, probe);
+        return NULL;
+    }
+
+    // there is no busy period to fall back on here, a long hyperperiod is simply cut off
+    long long window = set.hyperPeriod != HYPERPERIOD_OVERFLOW && set.hyperPeriod <= Boat.windowLimit ? set.hyperPeriod : Boat.windowLimit;
+    std::vector<std::vector<Segment>> coreSegments(Boat.cores);
+    GlobalCounters counters = simulateGlobal(set.simTasks, Boat.cores, globalPolicy(Boat.algorithm), window, [&](int core, int task, long long start, long long length)
+    {
+        addSegment(coreSegments[core], task, start, length);
+    });
+
+    for (int c = 0; c < Boat.cores; c++)
+    {
+        out << "Scheduling Diagram for CPU " << Boat.cpu << " core " << c + 1;
+        if (window != set.hyperPeriod)
+        {
+            out << " (first " << window << " time units)";
+        }
+        out << ": ";
+        convertToTaskSchedule(out, coreSegments[c], set.ranked, set.names);
+        out << "\n";
+    }
+    out << "Jobs: " << counters.jobs << ", preemptions: " << counters.preemptions << ", migrations: " << counters.migrations
+        << ", deadline misses: " << counters.misses << "\n";
+    if (counters.misses > 0)
+    {
+        out << "The task set is not schedulable\n";
+    }
+    out << "\n";
+    deliverReport(Boat, out, probe);
+    return NULL;
+}
+
+// the job the pool runs for every input line
+inline void runRMSA(void* arg)
+{
+    if (((args*)arg)->cores > 0)
+    {
+        globalRMSA(arg);
+    }
+    else if (((args*)arg)->algorithm == EARLIEST_DEADLINE_FIRST)
+    {
+        EDFA(arg);
+    }
+    else
+    {
+        RMSA(arg);
+    }
+    delete (args*)arg;
+}
+
+// one input line as a pool of tasks for --partition, packed onto cpus CPUs
+struct partitionArgs
+{
+    args Boat;        // what every CPU's RMSA gets, num is the slot of the summary
+    int pool;         // which input line it is
+    int cpus;
+    FitHeuristic fit;
+};
+
+// packs the pool, prints what went where and hands every CPU to RMSA in the slots after the summary
+inline void runPartition(void* arg)
+{
+    partitionArgs* job = (partitionArgs*)arg;
+    args& Boat = job->Boat;
+
+    TaskCursor fields(Boat.in.text, Boat.binaryIn);
+    std::vector<PartitionTask> tasks;
+    std::string_view name;
+    int wceTime, period;
+    while (fields.next(name, wceTime, period))
+    {
+        tasks.push_back({ name, wceTime, period });
+    }
+
+    Partition partition;
+    partitionTasks(tasks, job->cpus, job->fit, Boat.pool, partition);
+
+    // every CPU's tasks become an input line of their own, in the order the pool had them
+    ReportBuffer& out = workerBuffer();
+    out.clear();
+    out << "Task pool " << job->pool << ": " << (long long)tasks.size() << " tasks on " << job->cpus << " CPUs, "
+        << (job->fit == FIRST_FIT ? "first" : "best") << " fit decreasing\n";
+    std::vector<std::shared_ptr<std::string>> lines(job->cpus);
+    for (int c = 0; c < job->cpus; c++)
+    {
+        lines[c] = std::make_shared<std::string>();
+        ReportBuffer line;
+        out << "CPU " << c + 1 << ":";
+        const char* separator = " ";
+        for (size_t k = 0; k < tasks.size(); k++)
+        {
+            if (partition.cpuOf[k] == c)
+            {
+                out << separator << tasks[k].name;
+                line << tasks[k].name << ' ' << tasks[k].wcet << ' ' << tasks[k].period << ' ';
+                separator = ", ";
+            }
+        }
+        out << (*separator == ' ' ? " none\n" : "\n");
+        lines[c]->swap(line.text);
+    }
+
+    out << "Not placed:";
+    const char* separator = " ";
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (partition.cpuOf[k] < 0)
+        {
+            out << separator << tasks[k].name << " (WCET: " << tasks[k].wcet << ", Period: " << tasks[k].period << ")";
+            separator = ", ";
+        }
+    }
+    out << (*separator == ' ' ? " none\n\n" : "\n\n");
+    Boat.in = InputLine(); // done with the line
+    sendReport(Boat, out.text);
+
+    // to the front of our own deque backwards, so this worker goes on with CPU 1
+    for (int c = job->cpus - 1; c >= 0; c--)
+    {
+        args* cpuJob = new args(Boat);
+        cpuJob->num = Boat.num + 1 + c;
+        cpuJob->cpu = c + 1;
+        cpuJob->in.text = *lines[c];
+        cpuJob->in.keep = std::shared_ptr<const char>(lines[c], lines[c]->data());
+        cpuJob->binaryIn = false; // the line made up above, whatever the pool came in as
+        Boat.pool->push(StealingPool::currentWorker(), { runRMSA, cpuJob }, true);
+    }
+    delete job;
+}
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <algorithm>
+#include <vector>
+#include "ReadyQueue.h"
+
+// a task the way the simulator sees it, the caller hands them over in priority order (index 0 runs first)
+struct SimTask
+{
+    long long wcet;   // worst case execution time
+    long long period; // period (and implicit deadline)
+};
+
+// task number used in the diagram when nothing is running
+const int IDLE = -1;
+
+// one run of the schedule: task (an index into the tasks, or IDLE) runs for length time units from start
+struct Segment
+{
+    int task;
+    long long start;
+    long long length;
+};
+
+// hyperperiod value used when the lcm of the periods doesn't fit in 64 bits
+const long long HYPERPERIOD_OVERFLOW = -1;
+
+// hyperperiods longer than this only get their level-1 busy period simulated
+const long long DEFAULT_WINDOW_LIMIT = 100000000;
+
+// lcm that reports HYPERPERIOD_OVERFLOW instead of silently wrapping around. constexpr so the
+// compile time analysis in StaticSchedule.h can use it too
+constexpr long long checkedLcm(long long a, long long b)
+{
+    if (a == HYPERPERIOD_OVERFLOW || b == HYPERPERIOD_OVERFLOW)
+    {
+        return HYPERPERIOD_OVERFLOW;
+    }
+
+    long long x = a, y = b; // gcd first
+    while (y)
+    {
+        long long r = x % y;
+        x = y;
+        y = r;
+    }
+    if (!x)
+    {
+        return 0;
+    }
+
+    long long result = 0;
+    if (__builtin_mul_overflow(a / x, b, &result))
+    {
+        return HYPERPERIOD_OVERFLOW;
+    }
+    return result;
+}
+
+// length of the synchronous level-1 busy period: everything is released at 0 and the cpu stays
+// busy until it first goes idle, L = sum of ceil(L / T) * C. every task's worst case response
+// happens inside it (critical instant), so simulating just this window is enough to decide rm
+// schedulability. gives up at limit, since a set at utilization 1 never idles before the hyperperiod
+inline long long busyPeriod(const std::vector<SimTask>& tasks, long long limit)
+{
+    long long length = 0;
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (tasks[k].period > 0 && tasks[k].wcet > 0)
+        {
+            length += tasks[k].wcet;
+        }
+    }
+
+    while (length < limit)
+    {
+        long long demand = 0;
+        for (size_t k = 0; k < tasks.size(); k++)
+        {
+            if (tasks[k].period <= 0 || tasks[k].wcet <= 0)
+            {
+                continue;
+            }
+
+            long long jobs = length / tasks[k].period + (length % tasks[k].period != 0);
+            long long work;
+            if (__builtin_mul_overflow(jobs, tasks[k].wcet, &work) || __builtin_add_overflow(demand, work, &demand))
+            {
+                return limit;
+            }
+        }
+
+        if (demand == length)
+        {
+            return length;
+        }
+        length = demand;
+    }
+
+    return limit;
+}
+
+// how much of the timeline to simulate: the whole hyperperiod when it fits under limit,
+// otherwise only the level-1 busy period so time and memory stay bounded however big the lcm is
+inline long long simulationWindow(const std::vector<SimTask>& tasks, long long hyperPeriod, long long limit)
+{
+    if (hyperPeriod != HYPERPERIOD_OVERFLOW && hyperPeriod <= limit)
+    {
+        return hyperPeriod;
+    }
+    return busyPeriod(tasks, limit);
+}
+
+// event driven rate monotonic simulation of the piece [from, to) of the synchronous schedule.
+// instead of stepping one time unit at a time we jump straight to the next release or completion,
+// so the cost grows with the number of jobs simulated and not with the length of the timeline.
+// every run is reported as emit(task, start, length) where task is an index into tasks or IDLE.
+// the ready tasks live in a priority bitmap and the upcoming releases in a calendar heap,
+// so each event costs O(log n) and nothing is allocated once the loop starts.
+//
+// the simulation starts at start, pretending everything released before it is already done,
+// and only what happens from from on is reported. start = 0 is exact. a later start is exact
+// too as long as from - start is at least the level-1 busy period: the real backlog at start can
+// only last as long as one busy period, and once the real schedule idles both runs agree. so is
+// a start at an instant the real schedule has nothing left over, see idleInstant(). that lets
+// pieces of one long timeline be simulated independently of each other.
+template <typename Emit>
+void simulateRMSBetween(const std::vector<SimTask>& tasks, long long start, long long from, long long to, Emit emit)
+{
+    size_t n = tasks.size();
+    std::vector<long long> execLeft(n);
+    ReadyBitmap ready;
+    ReleaseCalendar calendar;
+    ready.reset(n);
+    calendar.reset(n);
+
+    for (size_t k = 0; k < n; k++)
+    {
+        if (tasks[k].period <= 0)
+        {
+            execLeft[k] = start == 0 ? tasks[k].wcet : 0;
+        }
+        else if (start == 0)
+        {
+            // the old tick loop skipped i == 1, so period 1 tasks miss their release at time 1
+            execLeft[k] = tasks[k].wcet;
+            calendar.add((int)k, tasks[k].period == 1 ? 2 : tasks[k].period);
+        }
+        else
+        {
+            execLeft[k] = start % tasks[k].period == 0 ? tasks[k].wcet : 0;
+            calendar.add((int)k, (start / tasks[k].period + 1) * tasks[k].period);
+        }
+
+        if (execLeft[k] > 0)
+        {
+            ready.set(k);
+        }
+    }
+
+    long long now = start;
+    while (now < to)
+    {
+        // nobody can run past the next release without being checked again
+        long long until = to;
+        if (!calendar.empty() && calendar.nextTime() < until)
+        {
+            until = calendar.nextTime();
+        }
+
+        long long length = until - now;
+        int task = IDLE;
+        size_t run = ready.first();
+        if (run != ReadyBitmap::npos)
+        {
+            if (execLeft[run] <= length)
+            {
+                length = execLeft[run];
+                ready.clear(run);
+            }
+            execLeft[run] -= length;
+            task = (int)run;
+        }
+
+        // anything before from is only there to get the backlog right
+        if (now + length > from)
+        {
+            emit(task, now < from ? from : now, now < from ? now + length - from : length);
+        }
+        now += length;
+
+        // release the jobs that arrive at this instant
+        while (!calendar.empty() && calendar.nextTime() == now)
+        {
+            int k = calendar.top();
+            execLeft[k] += tasks[k].wcet;
+            if (execLeft[k] > 0)
+            {
+                ready.set(k);
+            }
+            else
+            {
+                ready.clear(k);
+            }
+            calendar.advanceTop(now + tasks[k].period);
+        }
+    }
+    countTicks(now - start);
+}
+
+// where a piece starting at from has to start simulating to come out exact, busy is the level-1
+// busy period. anything that would start before time 2 starts at 0 instead because of the
+// missing release at time 1
+inline long long warmupStart(long long from, long long busy)
+{
+    return from - busy < 2 ? 0 : from - busy;
+}
+
+// true if every task releases a job every period from 0 on, which idleInstant() counts on. the old
+// tick loop's quirks break that: period 1 tasks miss time 1, periods of 0 or less release once
+inline bool regularReleases(const std::vector<SimTask>& tasks)
+{
+    for (size_t k = 0; k < tasks.size(); k++)
+    {
+        if (tasks[k].wcet < 0 || (tasks[k].wcet > 0 && tasks[k].period < 2))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the first instant from at on (end at the latest) at which the schedule has nothing left over:
+// everything released before it is done, so what comes after only depends on the time and a
+// piece of the timeline can be simulated from there with nothing to warm up. found without
+// simulating anyone: starting one busy period (busy) before at with an empty cpu, it hops from one
+// busy interval to the next, each ending at the fixed point t = from + work released in [from, t).
+// no busy interval outlasts the synchronous one, so the real schedule idles by at and the hops from
+// there on land on its own idle instants. only for regularReleases() tasks
+inline long long idleInstant(const std::vector<SimTask>& tasks, long long at, long long busy, long long end)
+{
+    long long from = at - busy < 0 ? 0 : at - busy;
+    while (from < at)
+    {
+        // the jobs released at from, if there are none the cpu stays idle until the next release
+        long long t = from;
+        long long next = at;
+        for (size_t k = 0; k < tasks.size(); k++)
+        {
+            if (tasks[k].wcet > 0)
+            {
+                t += from % tasks[k].period == 0 ? tasks[k].wcet : 0;
+                next = std::min(next, (from / tasks[k].period + 1) * tasks[k].period);
+            }
+        }
+        if (t == from)
+        {
+            from = next;
+            continue;
+        }
+
+        // everything released while the busy interval lasts makes it longer, until it stops growing
+        while (true)
+        {
+            long long demand = from;
+            for (size_t k = 0; k < tasks.size(); k++)
+            {
+                if (tasks[k].wcet <= 0)
+                {
+                    continue;
+                }
+
+                long long jobs = (t + tasks[k].period - 1) / tasks[k].period - (from + tasks[k].period - 1) / tasks[k].period;
+                long long work;
+                if (__builtin_mul_overflow(jobs, tasks[k].wcet, &work) || __builtin_add_overflow(demand, work, &demand))
+                {
+                    return end;
+                }
+            }
+
+            if (demand == t)
+            {
+                break;
+            }
+            t = demand;
+            if (t >= end)
+            {
+                return end;
+            }
+        }
+        from = t;
+    }
+    return from < end ? from : end;
+}
+
+// the whole timeline [0, hyperPeriod). the result is the same as the old tick loop, including
+// work piling up when a task overruns and period 1 tasks missing their release at time 1
+template <typename Emit>
+void simulateRMS(const std::vector<SimTask>& tasks, long long hyperPeriod, Emit emit)
+{
+    simulateRMSBetween(tasks, 0, 0, hyperPeriod, emit);
+}
+
+// adds a run to a schedule, gluing it onto the last one when the same task just keeps going,
+// so the list grows with the number of context switches and not with the length of the timeline
+inline void addSegment(std::vector<Segment>& segments, int task, long long start, long long length)
+{
+    if (!segments.empty() && segments.back().task == task && segments.back().start + segments.back().length == start)
+    {
+        segments.back().length += length;
+    }
+    else
+    {
+        segments.push_back({ task, start, length });
+    }
+}
+
+// the work tasks[i] and every task before it can ask for in the first t time units
+inline long long taskDemand(const std::vector<SimTask>& tasks, size_t i, long long t)
+{
+    long long demand = tasks[i].wcet > 0 ? tasks[i].wcet : 0;
+    for (size_t j = 0; j < i; j++)
+    {
+        if (tasks[j].period > 0 && tasks[j].wcet > 0)
+        {
+            demand += (t + tasks[j].period - 1) / tasks[j].period * tasks[j].wcet;
+        }
+    }
+    return demand;
+}
+
+// worst case response time of tasks[i] under the tasks before it, iterated up from start until it
+// settles or passes the period. start has to be at most the answer: the wcet always is, and so is
+// the response the task had before a higher priority task joined
+inline long long taskResponse(const std::vector<SimTask>& tasks, size_t i, long long start)
+{
+    long long response = start;
+
+    while (true)
+    {
+        long long demand = taskDemand(tasks, i, response);
+        if (demand == response || demand > tasks[i].period)
+        {
+            return demand;
+        }
+        response = demand;
+    }
+}
+
+// exact response time analysis for fixed priorities (tasks in priority order, deadline = period).
+// R = C + sum over higher priority tasks of ceil(R / T) * C, iterated from R = C until it settles.
+// that is pseudo-polynomial and never looks at the hyperperiod. responses gets every task's worst
+// case response time; a task that misses stops as soon as it passes its period, so
+// responses[k] > tasks[k].period marks the miss. returns true when every task makes it.
+inline bool responseTimeAnalysis(const std::vector<SimTask>& tasks, std::vector<long long>& responses)
+{
+    size_t n = tasks.size();
+    responses.assign(n, 0);
+    bool schedulable = true;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        responses[i] = taskResponse(tasks, i, tasks[i].wcet > 0 ? tasks[i].wcet : 0);
+        if (responses[i] > tasks[i].period)
+        {
+            schedulable = false;
+        }
+    }
+
+    return schedulable;
+}
+
+#endif
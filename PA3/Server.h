@@ -0,0 +1,412 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Input.h"
+#include "Pipeline.h"
+
+// the plumbing for --serve: a unix socket that any number of clients send input lines to and get
+// the reports back on, the way they would come out of stdout for the same input. one thread runs
+// the loop below, polling the listening socket and every client; the lines it reads go to the
+// caller as they come, and after every round of reads the caller hands them to its pool in one
+// go, so a burst from many clients is one batch. workers hand finished reports to the client's
+// Connection, which puts them back in order and wakes the loop to send them.
+//
+// a client's lines are numbered from 1 on their own, the same as a run over stdin would number
+// them. "exit" (or closing the socket for writing) ends the client's input; the socket is closed
+// once everything it asked for went out. SIGINT or SIGTERM stop taking new work and end the loop
+// once every client got its reports
+
+// how much is read off a client socket at a time
+const size_t SOCKET_CHUNK = 1 << 16;
+
+// a client that sends more than this without a newline is dropped, so nobody can make the server
+// hold on to any amount of memory for a line that never ends
+const size_t MAX_SERVE_LINE = 1 << 20;
+
+// set from the signal handler, the loop drains and returns once it sees it
+inline volatile sig_atomic_t serverStopping = 0;
+inline int serverSignalFd = -1;
+
+inline void stopServer(int)
+{
+    serverStopping = 1;
+    if (serverSignalFd >= 0)
+    {
+        char c = 0;
+        ssize_t ignored = write(serverSignalFd, &c, 1);
+        (void)ignored;
+    }
+}
+
+// the loop's self pipe. a byte in it means some client has reports to send, or a signal came in
+struct LoopWakeup
+{
+    int fds[2] = { -1, -1 };
+    std::atomic<bool> pending{ false }; // a byte is already on its way, no need for another
+
+    bool open()
+    {
+        if (pipe(fds) != 0)
+        {
+            return false;
+        }
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return true;
+    }
+
+    void close()
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+
+    void wake()
+    {
+        if (!pending.exchange(true))
+        {
+            char c = 0;
+            ssize_t ignored = write(fds[1], &c, 1); // a full pipe wakes the loop just as well
+            (void)ignored;
+        }
+    }
+
+    // the loop looks at every client after this, so anything woken for before it gets seen
+    void drain()
+    {
+        pending = false;
+        char bytes[64];
+        while (read(fds[0], bytes, sizeof(bytes)) > 0)
+        {
+        }
+    }
+};
+
+struct Connection
+{
+    int fd;
+    LoopWakeup* wakeup;
+
+    // only the loop touches these
+    std::string partial;     // the start of a line whose newline hasn't come yet
+    long long reserved = 0;  // last report number handed out
+    long long lines = 0;     // lines read so far
+    bool reading = true;     // false after exit or the end of its input
+    std::string sending;     // in order and partly sent
+    long long delivered = 0; // reports that were in order the last time the loop looked
+
+    // the workers' side, under mutex
+    pthread_mutex_t mutex;
+    long long next = 1;                     // the report that goes out next
+    std::map<long long, std::string> early; // finished before the ones in front of them
+    std::string output;                     // in order, for the loop to pick up
+
+    Connection(int socket, LoopWakeup* loop) : fd(socket), wakeup(loop)
+    {
+        pthread_mutex_init(&mutex, NULL);
+    }
+
+    ~Connection()
+    {
+        ::close(fd);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // worker side, like OrderedWriter::deliver. report is copied, so the worker keeps its buffer
+    void deliver(long long num, const std::string& report)
+    {
+        pthread_mutex_lock(&mutex);
+        if (num != next)
+        {
+            early[num] = report;
+            pthread_mutex_unlock(&mutex);
+            return;
+        }
+
+        output += report;
+        next++;
+        while (!early.empty() && early.begin()->first == next)
+        {
+            output += early.begin()->second;
+            early.erase(early.begin());
+            next++;
+        }
+        pthread_mutex_unlock(&mutex);
+        wakeup->wake();
+    }
+
+    // loop side: takes what is in order
+    void collect()
+    {
+        pthread_mutex_lock(&mutex);
+        if (sending.empty())
+        {
+            sending.swap(output);
+        }
+        else
+        {
+            sending += output;
+            output.clear();
+        }
+        delivered = next - 1;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // everything it asked for is out
+    bool finished() const
+    {
+        return !reading && delivered == reserved && sending.empty();
+    }
+};
+
+struct LineServer
+{
+    int listenFd = -1;
+    std::string path;
+    LoopWakeup wakeup;
+    std::vector<std::shared_ptr<Connection>> clients;
+
+    // binds the socket at socketPath, replacing a socket file left over from before. false with
+    // errno set if it can't
+    bool open(const char* socketPath)
+    {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(socketPath) >= sizeof(address.sun_path))
+        {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        strcpy(address.sun_path, socketPath);
+
+        if (!wakeup.open())
+        {
+            return false;
+        }
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (stat(socketPath, &info) == 0 && S_ISSOCK(info.st_mode))
+        {
+            unlink(socketPath);
+        }
+        if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0)
+        {
+            return false;
+        }
+        path = socketPath;
+
+        serverSignalFd = wakeup.fds[1];
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stopServer;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+        signal(SIGPIPE, SIG_IGN);
+        return true;
+    }
+
+    // reads what a client sent and hands every whole line to submit(client, line). the lines
+    // point into one shared chunk, nothing is copied per line. false if the client has to be
+    // dropped because its line got longer than MAX_SERVE_LINE
+    template <typename Submit>
+    bool receive(const std::shared_ptr<Connection>& client, Submit& submit)
+    {
+        std::shared_ptr<std::string> chunk = std::make_shared<std::string>();
+        chunk->swap(client->partial);
+        size_t carried = chunk->size();
+        chunk->resize(carried + SOCKET_CHUNK);
+        ssize_t got = recv(client->fd, &(*chunk)[carried], SOCKET_CHUNK, 0);
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            chunk->resize(carried);
+            client->partial.swap(*chunk);
+            return true;
+        }
+
+        // the end of its input, the last line may not have a newline
+        bool ended = got <= 0;
+        chunk->resize(carried + (got > 0 ? got : 0));
+        if (ended && !chunk->empty())
+        {
+            chunk->push_back('\n');
+        }
+
+        std::shared_ptr<const char> keep(chunk, chunk->data());
+        size_t start = 0, end;
+        while (client->reading && (end = chunk->find('\n', start)) != std::string::npos)
+        {
+            InputLine line;
+            line.text = std::string_view(chunk->data() + start, end - start);
+            line.keep = keep;
+            start = end + 1;
+            if (line.text == "exit")
+            {
+                client->reading = false;
+                break;
+            }
+            client->lines++;
+            submit(client, line);
+        }
+
+        if (ended)
+        {
+            client->reading = false;
+        }
+        if (client->reading)
+        {
+            if (chunk->size() - start > MAX_SERVE_LINE)
+            {
+                return false;
+            }
+            client->partial.assign(*chunk, start, std::string::npos);
+        }
+        return true;
+    }
+
+    // false if the client is gone
+    bool send(Connection& client)
+    {
+        while (!client.sending.empty())
+        {
+            ssize_t sent = ::send(client.fd, client.sending.data(), client.sending.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent < 0)
+            {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+            client.sending.erase(0, sent);
+        }
+        if (client.sending.capacity() > KEEP_REPORT)
+        {
+            std::string().swap(client.sending);
+        }
+        return true;
+    }
+
+    // runs until SIGINT or SIGTERM and every client is done. submit(client, line) gets every line,
+    // batch() is called after every round of reads
+    template <typename Submit, typename Batch>
+    void run(Submit submit, Batch batch)
+    {
+        std::vector<pollfd> polled;
+        while (true)
+        {
+            if (serverStopping && listenFd >= 0)
+            {
+                ::close(listenFd);
+                listenFd = -1;
+                unlink(path.c_str());
+                for (size_t i = 0; i < clients.size(); i++)
+                {
+                    clients[i]->reading = false;
+                }
+            }
+
+            size_t kept = 0;
+            for (size_t i = 0; i < clients.size(); i++)
+            {
+                if (!clients[i]->finished())
+                {
+                    clients[kept++] = clients[i];
+                }
+            }
+            clients.resize(kept);
+            if (listenFd < 0 && clients.empty())
+            {
+                break;
+            }
+
+            // a client that is IN_FLIGHT reports ahead of what it picked up isn't read from
+            polled.assign(1, { wakeup.fds[0], POLLIN, 0 });
+            if (listenFd >= 0)
+            {
+                polled.push_back({ listenFd, POLLIN, 0 });
+            }
+            for (size_t i = 0; i < clients.size(); i++)
+            {
+                Connection& client = *clients[i];
+                short events = 0;
+                if (client.reading && client.reserved - client.delivered < (long long)IN_FLIGHT)
+                {
+                    events |= POLLIN;
+                }
+                if (!client.sending.empty())
+                {
+                    events |= POLLOUT;
+                }
+                polled.push_back({ events ? client.fd : -1, events, 0 }); // nothing to wait for, not even a hang up
+            }
+
+            if (poll(polled.data(), polled.size(), -1) < 0 && errno != EINTR)
+            {
+                break;
+            }
+            if (polled[0].revents)
+            {
+                wakeup.drain();
+            }
+
+            if (listenFd >= 0 && polled[1].revents)
+            {
+                int fd;
+                while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                {
+                    clients.push_back(std::make_shared<Connection>(fd, &wakeup));
+                }
+            }
+
+            // clients accepted just now are polled from the next round on
+            size_t first = listenFd >= 0 ? 2 : 1;
+            kept = 0;
+            for (size_t i = 0; i < clients.size(); i++)
+            {
+                std::shared_ptr<Connection>& client = clients[i];
+                if (i + first < polled.size() && (polled[i + first].revents & (POLLIN | POLLHUP | POLLERR)) && client->reading
+                    && !receive(client, submit))
+                {
+                    continue;
+                }
+                client->collect();
+                if (send(*client))
+                {
+                    clients[kept++] = client;
+                }
+            }
+            clients.resize(kept); // a client that went away mid reply is dropped, its jobs still finish
+            batch();
+        }
+    }
+
+    // only once the workers are gone: a job for a client that was dropped can still finish after
+    // run() returns, and it wakes the loop through the pipe when it does
+    void close()
+    {
+        serverSignalFd = -1;
+        wakeup.close();
+    }
+};
+
+#endif
@@ -0,0 +1,75 @@
+// StaticSchedule.h at work on two fixed task tables. everything checked here is checked by the
+// compiler, so this only builds if the compile time analysis still gives the schedules below; the
+// program itself just prints them.
+//
+//   g++ -std=c++17 -O2 StaticExample.cpp -o static-example
+//   ./static-example
+
+#include <iostream>
+#include "StaticSchedule.h"
+
+// under the liu-layland bound, schedulable without the response time test
+constexpr StaticTask light[] = { { "B", 2, 6 }, { "A", 1, 4 } };
+
+// utilization 1: over the bound, the response time test lets it through
+constexpr StaticTask harmonic[] = { { "X", 2, 4 }, { "Y", 4, 8 } };
+
+// over the bound and Q's response time is 8 > 7, so asking for its schedule fails the build with
+// "this task table is not schedulable under rate monotonic, a task misses its deadline"
+// constexpr StaticTask missing[] = { { "P", 2, 5 }, { "Q", 4, 7 } };
+// constexpr auto& missingSchedule = StaticSchedule<missing>::segments;
+
+using Light = StaticSchedule<light>;
+using Harmonic = StaticSchedule<harmonic>;
+
+constexpr bool sameSegment(const Segment& a, const Segment& b)
+{
+    return a.task == b.task && a.start == b.start && a.length == b.length;
+}
+
+template <size_t N>
+constexpr bool sameSegments(const std::array<Segment, N>& got, const std::array<Segment, N>& want)
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (!sameSegment(got[i], want[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ranked: A (period 4) then B
+static_assert(Light::analysis.underBound, "light should pass on the bound alone");
+static_assert(Light::hyperPeriod == 12, "light's hyperperiod is lcm(4, 6)");
+static_assert(staticCompare(Light::ranked[0].name, "A") == 0, "A has the shorter period");
+static_assert(Light::segmentCount == 8, "light's schedule has 8 runs");
+static_assert(sameSegments(Light::segments, std::array<Segment, 8>{ {
+    { 0, 0, 1 }, { 1, 1, 2 }, { IDLE, 3, 1 }, { 0, 4, 1 }, { IDLE, 5, 1 }, { 1, 6, 2 }, { 0, 8, 1 }, { IDLE, 9, 3 } } }),
+    "light's schedule changed");
+
+static_assert(!Harmonic::analysis.underBound, "harmonic needs the response time test");
+static_assert(Harmonic::analysis.responses[0] == 2 && Harmonic::analysis.responses[1] == 8, "harmonic's response times changed");
+static_assert(Harmonic::hyperPeriod == 8, "harmonic's hyperperiod is 8");
+static_assert(sameSegments(Harmonic::segments, std::array<Segment, 4>{ { { 0, 0, 2 }, { 1, 2, 2 }, { 0, 4, 2 }, { 1, 6, 2 } } }),
+    "harmonic's schedule changed");
+
+template <typename Table>
+void printSchedule(const char* title)
+{
+    std::cout << title << " (hyperperiod " << Table::hyperPeriod << "):";
+    for (size_t i = 0; i < Table::segmentCount; i++)
+    {
+        const Segment& run = Table::segments[i];
+        std::cout << " " << (run.task == IDLE ? "Idle" : Table::ranked[run.task].name) << "(" << run.length << ")";
+    }
+    std::cout << "\n";
+}
+
+int main()
+{
+    printSchedule<Light>("light");
+    printSchedule<Harmonic>("harmonic");
+    return 0;
+}
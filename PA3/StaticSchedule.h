@@ -0,0 +1,277 @@
+#ifndef STATIC_SCHEDULE_H
+#define STATIC_SCHEDULE_H
+
+#include <array>
+#include <cstddef>
+#include "Scheduler.h"
+
+// the rate monotonic analysis of PA3.cpp, done by the compiler for a task table that is known
+// when building (firmware with a fixed set of tasks). same utilization, hyperperiod, liu-layland
+// bound, response time test and schedule as RMSA, but a set that doesn't make it fails the build
+// with a static_assert and the schedule ends up as a constant table:
+//
+//   constexpr StaticTask tasks[] = { { "A", 1, 4 }, { "B", 2, 6 } };
+//   using Table = StaticSchedule<tasks>;  // doesn't compile unless the set is schedulable
+//   Table::segments[i].task               // index into Table::ranked, or IDLE
+//
+// the simulation runs inside the compiler, so long hyperperiods may need a bigger
+// -fconstexpr-loop-limit / -fconstexpr-ops-limit
+
+struct StaticTask
+{
+    const char* name;
+    long long wcet;
+    long long period;
+};
+
+// strcmp the compiler can run
+constexpr int staticCompare(const char* a, const char* b)
+{
+    while (*a && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+// same order as higherPriority in PA3.cpp: shorter period first, then by name
+constexpr bool staticHigherPriority(const StaticTask& a, const StaticTask& b)
+{
+    if (a.period == b.period)
+        return staticCompare(a.name, b.name) < 0;
+
+    return a.period < b.period;
+}
+
+// the tasks in rate monotonic order, a stable insertion sort like the stable_sort in RMSA
+template <size_t N>
+constexpr std::array<StaticTask, N> staticRank(const StaticTask (&tasks)[N])
+{
+    std::array<StaticTask, N> ranked{};
+    for (size_t i = 0; i < N; i++)
+    {
+        size_t j = i;
+        while (j > 0 && staticHigherPriority(tasks[i], ranked[j - 1]))
+        {
+            ranked[j] = ranked[j - 1];
+            j--;
+        }
+        ranked[j] = tasks[i];
+    }
+    return ranked;
+}
+
+// 2^(1/n) by newton's method, std::pow isn't constexpr
+constexpr double staticRootOfTwo(int n)
+{
+    double x = 2;
+    for (int step = 0; step < 100; step++)
+    {
+        double power = 1;
+        for (int k = 1; k < n; k++)
+        {
+            power *= x;
+        }
+        double next = x - (power * x - 2) / (n * power);
+        if (next == x)
+        {
+            break;
+        }
+        x = next;
+    }
+    return x;
+}
+
+// liuLaylandBound in Analysis.h, n(2^(1/n) - 1)
+constexpr double staticLiuLayland(int n)
+{
+    return n * (staticRootOfTwo(n) - 1);
+}
+
+template <size_t N>
+struct StaticAnalysis
+{
+    double utilization;
+    long long hyperPeriod;            // HYPERPERIOD_OVERFLOW if it doesn't fit in 64 bits
+    double bound;                     // liu-layland bound for N tasks
+    bool underBound;                  // schedulable by the bound alone
+    std::array<long long, N> responses; // worst case response time of every ranked task, > period on a miss
+    bool schedulable;
+};
+
+// RMSA's decision: over 1 is out, under the bound is in, anything between goes to the exact
+// response time test (responseTimeAnalysis in Scheduler.h)
+template <size_t N>
+constexpr StaticAnalysis<N> analyzeStatic(const StaticTask (&tasks)[N])
+{
+    StaticAnalysis<N> result{};
+    std::array<StaticTask, N> ranked = staticRank(tasks);
+
+    result.hyperPeriod = tasks[0].period;
+    for (size_t k = 0; k < N; k++)
+    {
+        result.utilization += (double)tasks[k].wcet / (double)tasks[k].period;
+        result.hyperPeriod = checkedLcm(result.hyperPeriod, tasks[k].period);
+    }
+    result.bound = staticLiuLayland((int)N);
+    result.underBound = result.utilization <= result.bound;
+
+    bool responsesMet = true;
+    for (size_t i = 0; i < N; i++)
+    {
+        long long wcet = ranked[i].wcet > 0 ? ranked[i].wcet : 0;
+        long long response = wcet;
+        while (true)
+        {
+            long long demand = wcet;
+            for (size_t j = 0; j < i; j++)
+            {
+                if (ranked[j].period > 0 && ranked[j].wcet > 0)
+                {
+                    demand += (response + ranked[j].period - 1) / ranked[j].period * ranked[j].wcet;
+                }
+            }
+
+            bool settled = demand == response || demand > ranked[i].period;
+            response = demand;
+            if (settled)
+            {
+                break;
+            }
+        }
+
+        result.responses[i] = response;
+        if (response > ranked[i].period)
+        {
+            responsesMet = false;
+        }
+    }
+
+    result.schedulable = result.utilization <= 1 && (result.underBound || responsesMet);
+    return result;
+}
+
+// simulateRMS without the heap and the bitmap, which aren't constexpr: every event scans the
+// tasks instead. visit gets the same (task, start, length) runs, period 1 quirk included
+template <size_t N, typename Visit>
+constexpr void staticSimulate(const std::array<StaticTask, N>& ranked, long long to, Visit& visit)
+{
+    long long execLeft[N] = {};
+    long long release[N] = {}; // next release of each task, -1 if it never releases
+    for (size_t k = 0; k < N; k++)
+    {
+        execLeft[k] = ranked[k].wcet;
+        release[k] = ranked[k].period <= 0 ? -1 : ranked[k].period == 1 ? 2 : ranked[k].period;
+    }
+
+    long long now = 0;
+    while (now < to)
+    {
+        long long until = to;
+        int run = IDLE;
+        for (size_t k = 0; k < N; k++)
+        {
+            if (release[k] >= 0 && release[k] < until)
+            {
+                until = release[k];
+            }
+            if (run == IDLE && execLeft[k] > 0)
+            {
+                run = (int)k;
+            }
+        }
+
+        long long length = until - now;
+        if (run != IDLE)
+        {
+            if (execLeft[run] < length)
+            {
+                length = execLeft[run];
+            }
+            execLeft[run] -= length;
+        }
+        visit(run, now, length);
+        now += length;
+
+        for (size_t k = 0; k < N; k++)
+        {
+            if (release[k] == now)
+            {
+                execLeft[k] += ranked[k].wcet;
+                release[k] += ranked[k].period;
+            }
+        }
+    }
+}
+
+// counts the segments addSegment would keep, so the table can be sized
+struct StaticSegmentCounter
+{
+    size_t count = 0;
+    int last = IDLE - 1;
+
+    constexpr void operator()(int task, long long, long long)
+    {
+        if (task != last)
+        {
+            count++;
+            last = task;
+        }
+    }
+};
+
+// fills the table, gluing runs of the same task together like addSegment
+template <size_t Count>
+struct StaticSegmentWriter
+{
+    std::array<Segment, Count> segments{};
+    size_t used = 0;
+
+    constexpr void operator()(int task, long long start, long long length)
+    {
+        if (used > 0 && segments[used - 1].task == task)
+        {
+            segments[used - 1].length += length;
+        }
+        else
+        {
+            segments[used++] = Segment{ task, start, length };
+        }
+    }
+};
+
+template <size_t N>
+constexpr size_t countStaticSegments(const StaticTask (&tasks)[N], long long hyperPeriod)
+{
+    StaticSegmentCounter counter;
+    staticSimulate(staticRank(tasks), hyperPeriod, counter);
+    return counter.count;
+}
+
+template <size_t Count, size_t N>
+constexpr std::array<Segment, Count> buildStaticSchedule(const StaticTask (&tasks)[N], long long hyperPeriod)
+{
+    StaticSegmentWriter<Count> writer;
+    staticSimulate(staticRank(tasks), hyperPeriod, writer);
+    return writer.segments;
+}
+
+// everything about one task table, worked out at compile time
+template <const auto& Tasks>
+struct StaticSchedule
+{
+    static constexpr size_t taskCount = sizeof(Tasks) / sizeof(Tasks[0]);
+    static constexpr std::array<StaticTask, taskCount> ranked = staticRank(Tasks);
+    static constexpr StaticAnalysis<taskCount> analysis = analyzeStatic(Tasks);
+
+    static_assert(analysis.hyperPeriod != HYPERPERIOD_OVERFLOW, "the hyperperiod of this task table doesn't fit in 64 bits");
+    static_assert(analysis.utilization <= 1, "this task table needs more than 100% of the cpu");
+    static_assert(analysis.schedulable, "this task table is not schedulable under rate monotonic, a task misses its deadline");
+
+    static constexpr long long hyperPeriod = analysis.hyperPeriod;
+    static constexpr size_t segmentCount = countStaticSegments(Tasks, analysis.schedulable ? hyperPeriod : 0);
+    static constexpr std::array<Segment, segmentCount> segments = buildStaticSchedule<segmentCount>(Tasks, analysis.schedulable ? hyperPeriod : 0);
+};
+
+#endif
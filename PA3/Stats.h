@@ -0,0 +1,365 @@
+#ifndef STATS_H
+#define STATS_H
+
+// performance counters for every task set and every thread. they only exist when the program is
+// built with -DPA3_STATS; without it every hook in here is an empty inline function and the
+// probes are empty structs, so the normal build doesn't pay anything for them.
+//
+// with it, --stats FILE writes them out as JSON (or CSV with --stats-format csv) when the program
+// exits and whenever it gets SIGUSR1. FILE - means stderr. only the first MAX_SET_STATS sets get a
+// line of their own, so a long --serve session doesn't grow without end; the thread totals count
+// every set. without --stats nothing is kept per set at all.
+
+#include <pthread.h>
+#include <signal.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// what one task set cost
+struct SetStats
+{
+    long long num;         // CPU number of the set
+    int thread;            // thread that finished it
+    long long parseNs;     // reading the line into tasks
+    long long analysisNs;  // tests, simulation and formatting, summed over all threads for split sets
+    long long ticks;       // time units simulated, warm-ups included
+    long long heapOps;     // sift operations on the release calendar
+    long long outputBytes; // size of the report
+    long long waitNs;      // from handing the report over until it was printed
+};
+
+// the same, summed up for one thread. waitNs is the writer waiting to print for a writer thread and
+// the reader waiting for room for a reader thread
+struct ThreadStats
+{
+    std::string role;
+    long long sets;
+    long long parseNs;
+    long long analysisNs;
+    long long ticks;
+    long long heapOps;
+    long long outputBytes;
+    long long waitNs;
+};
+
+// counters the engines bump on the thread they run on
+struct StatCounters
+{
+    long long ticks;
+    long long heapOps;
+};
+
+inline StatCounters& statCounters()
+{
+    static thread_local StatCounters counters = { 0, 0 };
+    return counters;
+}
+
+// nanoseconds on a monotonic clock, always 0 when stats are off so nothing gets measured
+inline long long statClock()
+{
+#ifdef PA3_STATS
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return 0;
+#endif
+}
+
+inline void countTicks(long long n)
+{
+#ifdef PA3_STATS
+    statCounters().ticks += n;
+#else
+    (void)n;
+#endif
+}
+
+inline void countHeapOp()
+{
+#ifdef PA3_STATS
+    statCounters().heapOps++;
+#endif
+}
+
+#ifdef PA3_STATS
+
+// sets past this many only count towards their thread's totals
+const size_t MAX_SET_STATS = 1 << 20;
+
+// everything recorded so far, guarded by mutex
+struct StatsRegistry
+{
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    std::vector<SetStats> sets;
+    long long setsNotKept = 0;                   // sets that came after the first MAX_SET_STATS
+    std::unordered_map<long long, size_t> byNum; // where each set not printed yet sits in sets
+    std::vector<ThreadStats> threads;
+    std::string path;                            // where to write them, empty for nowhere
+    bool csv = false;
+};
+
+inline StatsRegistry& statsRegistry()
+{
+    static StatsRegistry registry;
+    return registry;
+}
+
+// the calling thread's number, it gets one the first time it records anything. call with the mutex held
+inline int statsThreadLocked(const char* role)
+{
+    static thread_local int id = -1;
+    StatsRegistry& r = statsRegistry();
+    if (id < 0)
+    {
+        id = (int)r.threads.size();
+        r.threads.push_back({ role, 0, 0, 0, 0, 0, 0, 0 });
+    }
+    return id;
+}
+
+#endif
+
+// time a thread spent waiting, role says what kind of thread it is
+inline void statsWaited(const char* role, long long ns)
+{
+#ifdef PA3_STATS
+    StatsRegistry& r = statsRegistry();
+    pthread_mutex_lock(&r.mutex);
+    r.threads[statsThreadLocked(role)].waitNs += ns;
+    pthread_mutex_unlock(&r.mutex);
+#else
+    (void)role;
+    (void)ns;
+#endif
+}
+
+// the writer printed report num, ns after it was handed over
+inline void statsPrinted(long long num, long long ns)
+{
+#ifdef PA3_STATS
+    StatsRegistry& r = statsRegistry();
+    pthread_mutex_lock(&r.mutex);
+    std::unordered_map<long long, size_t>::iterator it = r.byNum.find(num);
+    if (it != r.byNum.end())
+    {
+        r.sets[it->second].waitNs = ns;
+        r.byNum.erase(it); // printed, nothing else comes for it
+    }
+    r.threads[statsThreadLocked("writer")].waitNs += ns;
+    pthread_mutex_unlock(&r.mutex);
+#else
+    (void)num;
+    (void)ns;
+#endif
+}
+
+// measures one task set. start() on every thread that picks the set up, parsed() and analyzed()
+// put the time and the counters since then into that phase. a set split over several threads
+// gets one probe per piece, merged into the set's own probe before it is recorded
+struct SetProbe
+{
+#ifdef PA3_STATS
+    SetStats stats = { 0, -1, 0, 0, 0, 0, 0, 0 };
+    long long mark = 0;
+    StatCounters base = { 0, 0 };
+
+    void start()
+    {
+        mark = statClock();
+        base = statCounters();
+    }
+
+    long long lap()
+    {
+        long long now = statClock();
+        long long spent = now - mark;
+        mark = now;
+        stats.ticks += statCounters().ticks - base.ticks;
+        stats.heapOps += statCounters().heapOps - base.heapOps;
+        base = statCounters();
+        return spent;
+    }
+
+    void parsed()
+    {
+        stats.parseNs += lap();
+    }
+
+    void analyzed()
+    {
+        stats.analysisNs += lap();
+    }
+
+    void merge(const SetProbe& other)
+    {
+        stats.parseNs += other.stats.parseNs;
+        stats.analysisNs += other.stats.analysisNs;
+        stats.ticks += other.stats.ticks;
+        stats.heapOps += other.stats.heapOps;
+    }
+
+    // call before handing the report over, so the writer finds it
+    void record(long long num, size_t outputBytes)
+    {
+        StatsRegistry& r = statsRegistry();
+        pthread_mutex_lock(&r.mutex);
+        stats.num = num;
+        stats.thread = statsThreadLocked("worker");
+        stats.outputBytes = outputBytes;
+
+        ThreadStats& t = r.threads[stats.thread];
+        t.sets++;
+        t.parseNs += stats.parseNs;
+        t.analysisNs += stats.analysisNs;
+        t.ticks += stats.ticks;
+        t.heapOps += stats.heapOps;
+        t.outputBytes += outputBytes;
+
+        // a line of its own only goes to a --stats file, and only for so many sets
+        if (r.sets.size() >= MAX_SET_STATS)
+        {
+            r.setsNotKept++;
+        }
+        else if (!r.path.empty())
+        {
+            r.byNum[num] = r.sets.size();
+            r.sets.push_back(stats);
+        }
+        pthread_mutex_unlock(&r.mutex);
+    }
+#else
+    void start() {}
+    void parsed() {}
+    void analyzed() {}
+    void merge(const SetProbe&) {}
+    void record(long long, size_t) {}
+#endif
+};
+
+#ifdef PA3_STATS
+
+inline void writeStatsJson(FILE* file, const StatsRegistry& r)
+{
+    fprintf(file, "{\"sets\": [");
+    for (size_t i = 0; i < r.sets.size(); i++)
+    {
+        const SetStats& s = r.sets[i];
+        fprintf(file, "%s\n  {\"cpu\": %lld, \"thread\": %d, \"parse_ns\": %lld, \"analysis_ns\": %lld, \"ticks\": %lld, \"heap_ops\": %lld, \"output_bytes\": %lld, \"wait_ns\": %lld}",
+            i ? "," : "", s.num, s.thread, s.parseNs, s.analysisNs, s.ticks, s.heapOps, s.outputBytes, s.waitNs);
+    }
+    fprintf(file, "\n],\n\"sets_not_kept\": %lld,\n\"threads\": [", r.setsNotKept);
+    for (size_t i = 0; i < r.threads.size(); i++)
+    {
+        const ThreadStats& t = r.threads[i];
+        fprintf(file, "%s\n  {\"thread\": %d, \"role\": \"%s\", \"sets\": %lld, \"parse_ns\": %lld, \"analysis_ns\": %lld, \"ticks\": %lld, \"heap_ops\": %lld, \"output_bytes\": %lld, \"wait_ns\": %lld}",
+            i ? "," : "", (int)i, t.role.c_str(), t.sets, t.parseNs, t.analysisNs, t.ticks, t.heapOps, t.outputBytes, t.waitNs);
+    }
+    fprintf(file, "\n]}\n");
+}
+
+// one table, the kind column tells set rows from thread rows
+inline void writeStatsCsv(FILE* file, const StatsRegistry& r)
+{
+    fprintf(file, "kind,cpu,thread,role,sets,parse_ns,analysis_ns,ticks,heap_ops,output_bytes,wait_ns\n");
+    for (size_t i = 0; i < r.sets.size(); i++)
+    {
+        const SetStats& s = r.sets[i];
+        fprintf(file, "set,%lld,%d,%s,1,%lld,%lld,%lld,%lld,%lld,%lld\n", s.num, s.thread, r.threads[s.thread].role.c_str(),
+            s.parseNs, s.analysisNs, s.ticks, s.heapOps, s.outputBytes, s.waitNs);
+    }
+    for (size_t i = 0; i < r.threads.size(); i++)
+    {
+        const ThreadStats& t = r.threads[i];
+        fprintf(file, "thread,,%d,%s,%lld,%lld,%lld,%lld,%lld,%lld,%lld\n", (int)i, t.role.c_str(),
+            t.sets, t.parseNs, t.analysisNs, t.ticks, t.heapOps, t.outputBytes, t.waitNs);
+    }
+}
+
+#endif
+
+// writes everything recorded so far to the --stats file, replacing what was there
+inline void writeStats()
+{
+#ifdef PA3_STATS
+    StatsRegistry& r = statsRegistry();
+    pthread_mutex_lock(&r.mutex);
+    if (!r.path.empty())
+    {
+        FILE* file = r.path == "-" ? stderr : fopen(r.path.c_str(), "w");
+        if (file)
+        {
+            if (r.csv)
+            {
+                writeStatsCsv(file, r);
+            }
+            else
+            {
+                writeStatsJson(file, r);
+            }
+            if (file == stderr)
+            {
+                fflush(file);
+            }
+            else
+            {
+                fclose(file);
+            }
+        }
+    }
+    pthread_mutex_unlock(&r.mutex);
+#endif
+}
+
+#ifdef PA3_STATS
+
+inline void* statsSignalThread(void*)
+{
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    while (true)
+    {
+        int signal;
+        if (sigwait(&usr1, &signal) == 0)
+        {
+            writeStats();
+        }
+    }
+    return NULL;
+}
+
+#endif
+
+// sets up --stats. call it before any other thread is started: SIGUSR1 gets blocked here, every
+// thread inherits that, and one thread that does nothing but sigwait for it writes the file
+inline bool startStats(const std::string& path, const std::string& format)
+{
+#ifdef PA3_STATS
+    StatsRegistry& r = statsRegistry();
+    r.path = path;
+    r.csv = format == "csv";
+
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &usr1, NULL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, statsSignalThread, NULL))
+    {
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+#else
+    (void)path;
+    (void)format;
+    fprintf(stderr, "--stats needs a build with -DPA3_STATS, ignoring it\n");
+    return true;
+#endif
+}
+
+#endif
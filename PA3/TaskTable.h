@@ -0,0 +1,107 @@
+#ifndef TASK_TABLE_H
+#define TASK_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the task names of one set, each one stored once. tasks only carry the 32 bit id of their name,
+// so they stay small plain records that copy and compare without touching any strings
+struct NameTable
+{
+    static constexpr uint32_t EMPTY = 0xffffffff;
+
+    std::string chars;             // every name back to back
+    std::vector<uint32_t> offsets; // name i is chars[offsets[i], offsets[i + 1])
+    std::vector<uint32_t> slots;   // open addressing hash of the ids, EMPTY where nothing is
+
+    NameTable() : offsets(1, 0) {}
+
+    size_t size() const
+    {
+        return offsets.size() - 1;
+    }
+
+    std::string_view get(uint32_t id) const
+    {
+        return std::string_view(chars.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    void clear()
+    {
+        chars.clear();
+        offsets.assign(1, 0);
+        slots.clear();
+    }
+
+    // the id of name, a new one the first time it shows up
+    uint32_t intern(std::string_view name)
+    {
+        if (2 * (size() + 1) > slots.size())
+        {
+            grow();
+        }
+
+        size_t mask = slots.size() - 1;
+        size_t i = std::hash<std::string_view>()(name) & mask;
+        while (slots[i] != EMPTY)
+        {
+            if (get(slots[i]) == name)
+            {
+                return slots[i];
+            }
+            i = (i + 1) & mask;
+        }
+
+        uint32_t id = (uint32_t)size();
+        chars.append(name.data(), name.size());
+        offsets.push_back((uint32_t)chars.size());
+        slots[i] = id;
+        return id;
+    }
+
+    void grow()
+    {
+        slots.assign(slots.empty() ? 16 : 2 * slots.size(), EMPTY);
+        size_t mask = slots.size() - 1;
+        for (uint32_t id = 0; id < size(); id++)
+        {
+            size_t i = std::hash<std::string_view>()(get(id)) & mask;
+            while (slots[i] != EMPTY)
+            {
+                i = (i + 1) & mask;
+            }
+            slots[i] = id;
+        }
+    }
+
+    // ranks[id] is where name id comes in alphabetical order, so names compare as integers
+    void rank(std::vector<uint32_t>& ranks) const
+    {
+        std::vector<uint32_t> order(size());
+        for (uint32_t id = 0; id < order.size(); id++)
+        {
+            order[id] = id;
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return get(a) < get(b); });
+
+        ranks.resize(size());
+        for (uint32_t r = 0; r < order.size(); r++)
+        {
+            ranks[order[r]] = r;
+        }
+    }
+};
+
+// rate monotonic priority as one number, smaller runs first: the period in the high half (with
+// the sign bit flipped so negative periods still sort below positive ones), the name's
+// alphabetical rank in the low half. ranking a set is then a single integer compare per pair
+inline uint64_t priorityKey(int period, uint32_t nameRank)
+{
+    return (uint64_t)((uint32_t)period ^ 0x80000000u) << 32 | nameRank;
+}
+
+#endif
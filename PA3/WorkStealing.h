@@ -0,0 +1,319 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+// a unit of work for the pool: run(arg) on whichever worker gets to it
+struct Job
+{
+    void (*run)(void*);
+    void* arg;
+};
+
+// one deque per worker. the owner takes jobs from the front, so its own lines come out in
+// input order and the chunks it just split off are next in line. idle workers steal from the
+// back of someone else's deque, which is where the work furthest from being printed sits.
+struct WorkerQueue
+{
+    pthread_mutex_t mutex;
+    std::deque<Job> jobs;
+};
+
+// a job runAll() waits for
+struct GroupedJob
+{
+    Job job;
+    std::atomic<size_t>* left;
+};
+
+inline void runGrouped(void* arg)
+{
+    GroupedJob* grouped = (GroupedJob*)arg;
+    grouped->job.run(grouped->job.arg);
+    grouped->left->fetch_sub(1, std::memory_order_release);
+}
+
+struct StealingPool
+{
+    std::vector<WorkerQueue> queues;
+    long outstanding;       // jobs pushed but not finished yet, guarded by mutex
+    long pushes;            // bumped on every push so sleeping workers notice new work
+    pthread_mutex_t mutex;  // for outstanding, pushes and sleeping
+    pthread_cond_t wakeup;  // idle workers sleep here
+
+    StealingPool(int nWorkers) : queues(nWorkers), outstanding(0), pushes(0)
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            pthread_mutex_init(&queues[i].mutex, NULL);
+        }
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&wakeup, NULL);
+    }
+
+    ~StealingPool()
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            pthread_mutex_destroy(&queues[i].mutex);
+        }
+        pthread_mutex_destroy(&mutex);
+        pthread_cond_destroy(&wakeup);
+    }
+
+    int size() const
+    {
+        return (int)queues.size();
+    }
+
+    // worker number of the calling thread, -1 outside the pool
+    static int& currentWorker()
+    {
+        static thread_local int id = -1;
+        return id;
+    }
+
+    // queue a job on a worker's deque, at the front when it should run before what is already there
+    void push(int worker, Job job, bool front)
+    {
+        pthread_mutex_lock(&mutex);
+        outstanding++;
+        pushes++;
+        pthread_mutex_unlock(&mutex);
+
+        WorkerQueue& q = queues[worker < 0 ? 0 : worker % queues.size()];
+        pthread_mutex_lock(&q.mutex);
+        if (front)
+        {
+            q.jobs.push_front(job);
+        }
+        else
+        {
+            q.jobs.push_back(job);
+        }
+        pthread_mutex_unlock(&q.mutex);
+
+        pthread_mutex_lock(&mutex);
+        pthread_cond_broadcast(&wakeup);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // push for a batch of jobs from outside the pool, dealt out over the deques starting at worker
+    // first. every deque is locked once and the sleeping workers get one wakeup for all of them
+    void pushAll(const std::vector<Job>& jobs, size_t first)
+    {
+        if (jobs.empty())
+        {
+            return;
+        }
+
+        pthread_mutex_lock(&mutex);
+        outstanding += (long)jobs.size();
+        pushes++;
+        pthread_mutex_unlock(&mutex);
+
+        for (size_t i = 0; i < queues.size() && i < jobs.size(); i++)
+        {
+            WorkerQueue& q = queues[(first + i) % queues.size()];
+            pthread_mutex_lock(&q.mutex);
+            for (size_t k = i; k < jobs.size(); k += queues.size())
+            {
+                q.jobs.push_back(jobs[k]);
+            }
+            pthread_mutex_unlock(&q.mutex);
+        }
+
+        pthread_mutex_lock(&mutex);
+        pthread_cond_broadcast(&wakeup);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // own deque first, then try to steal from everybody else starting with the next worker
+    bool take(int worker, Job& job)
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            WorkerQueue& q = queues[(worker + i) % queues.size()];
+            pthread_mutex_lock(&q.mutex);
+            if (!q.jobs.empty())
+            {
+                if (i == 0)
+                {
+                    job = q.jobs.front();
+                    q.jobs.pop_front();
+                }
+                else
+                {
+                    job = q.jobs.back();
+                    q.jobs.pop_back();
+                }
+                pthread_mutex_unlock(&q.mutex);
+                return true;
+            }
+            pthread_mutex_unlock(&q.mutex);
+        }
+        return false;
+    }
+
+    // keeps the workers around while jobs are still being fed in, even if they run dry for a bit
+    void hold()
+    {
+        pthread_mutex_lock(&mutex);
+        outstanding++;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // no more jobs will come from whoever called hold()
+    void release()
+    {
+        pthread_mutex_lock(&mutex);
+        if (--outstanding == 0)
+        {
+            pthread_cond_broadcast(&wakeup);
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // runs a job that was taken off a deque
+    void runJob(Job job)
+    {
+        job.run(job.arg);
+
+        pthread_mutex_lock(&mutex);
+        if (--outstanding == 0)
+        {
+            pthread_cond_broadcast(&wakeup); // let everybody go home
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // fork and join for a job that wants a few things done in parallel: jobs[1..] go to the front
+    // of the caller's deque for idle workers to steal, the caller runs jobs[0] and then whatever
+    // it can take until all of them are done, so waiting here never ties up a worker. only from
+    // a pool thread; anywhere else the jobs just run one after another
+    void runAll(const std::vector<Job>& jobs)
+    {
+        int worker = currentWorker();
+        if (worker < 0 || jobs.size() < 2)
+        {
+            for (size_t i = 0; i < jobs.size(); i++)
+            {
+                jobs[i].run(jobs[i].arg);
+            }
+            return;
+        }
+
+        std::atomic<size_t> left(jobs.size() - 1);
+        std::vector<GroupedJob> grouped(jobs.size());
+        for (size_t i = jobs.size() - 1; i > 0; i--)
+        {
+            grouped[i].job = jobs[i];
+            grouped[i].left = &left;
+            push(worker, { runGrouped, &grouped[i] }, true);
+        }
+        jobs[0].run(jobs[0].arg);
+
+        while (left.load(std::memory_order_acquire) > 0)
+        {
+            Job job;
+            if (take(worker, job))
+            {
+                runJob(job);
+            }
+            else
+            {
+                sched_yield(); // the rest is running on other workers
+            }
+        }
+    }
+
+    // what every pool thread runs until all jobs, including the ones pushed while running, are done
+    void work(int worker)
+    {
+        currentWorker() = worker;
+
+        while (true)
+        {
+            pthread_mutex_lock(&mutex);
+            long seen = pushes;
+            pthread_mutex_unlock(&mutex);
+
+            Job job;
+            if (take(worker, job))
+            {
+                runJob(job);
+                continue;
+            }
+
+            // nothing to steal, sleep until someone pushes or everything is finished
+            pthread_mutex_lock(&mutex);
+            while (outstanding > 0 && pushes == seen)
+            {
+                pthread_cond_wait(&wakeup, &mutex);
+            }
+            bool finished = outstanding == 0;
+            pthread_mutex_unlock(&mutex);
+
+            if (finished)
+            {
+                break;
+            }
+        }
+
+        currentWorker() = -1;
+    }
+};
+
+struct StealingWorkerArgs
+{
+    StealingPool* pool;
+    int worker;
+};
+
+inline void* stealingWorker(void* void_ptr)
+{
+    StealingWorkerArgs* a = (StealingWorkerArgs*)void_ptr;
+    a->pool->work(a->worker);
+    return NULL;
+}
+
+// the threads behind a pool, one per deque
+struct StealingThreads
+{
+    std::vector<pthread_t> tid;
+    std::vector<StealingWorkerArgs> workerArgs;
+    int started;
+
+    // false if not every thread could be created, the ones that did still drain the pool
+    bool start(StealingPool& pool)
+    {
+        tid.resize(pool.size());
+        workerArgs.resize(pool.size());
+
+        for (started = 0; started < pool.size(); started++)
+        {
+            workerArgs[started].pool = &pool;
+            workerArgs[started].worker = started;
+            if (pthread_create(&tid[started], NULL, stealingWorker, &workerArgs[started]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // waits until the pool has drained
+    void join()
+    {
+        for (int i = 0; i < started; i++)
+        {
+            pthread_join(tid[i], NULL);
+        }
+    }
+};
+
+#endif
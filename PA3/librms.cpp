@@ -0,0 +1,223 @@
+// the C interface of librms.h over the analysis in Analysis.h
+
+#include <algorithm>
+#include <climits>
+#include <new>
+#include <string_view>
+#include <vector>
+#include "librms.h"
+#include "Scheduler.h"
+#include "Input.h"
+#include "Analysis.h"
+
+struct rms_result
+{
+    rms_verdict verdict;
+    double utilization;
+    std::vector<size_t> order; // order[k] is where the k-th task in rate monotonic order was given
+    SetResult set;
+};
+
+static std::string_view nameOf(const rms_task& task)
+{
+    return task.name_length ? std::string_view(task.name, task.name_length) : std::string_view();
+}
+
+static int analyze(const rms_task* tasks, size_t count, int64_t windowLimit, int flags, rms_result* result)
+{
+    // the analysis works in the int range the text input has, past it the response time sums overflow
+    for (size_t k = 0; k < count; k++)
+    {
+        if (tasks[k].wcet < 0 || tasks[k].wcet > INT_MAX || tasks[k].period < 1 || tasks[k].period > INT_MAX
+            || (!tasks[k].name && tasks[k].name_length))
+        {
+            return RMS_INVALID_TASK;
+        }
+    }
+
+    // rate monotonic like RMSA ranks it, a task of the same period and name stays where it was given
+    result->order.resize(count);
+    for (size_t k = 0; k < count; k++)
+    {
+        result->order[k] = k;
+    }
+    std::stable_sort(result->order.begin(), result->order.end(), [&](size_t a, size_t b)
+    {
+        if (tasks[a].period != tasks[b].period)
+        {
+            return tasks[a].period < tasks[b].period;
+        }
+        return nameOf(tasks[a]) < nameOf(tasks[b]);
+    });
+
+    std::vector<SimTask> inOrder, ranked;
+    for (size_t k = 0; k < count; k++)
+    {
+        inOrder.push_back({ tasks[k].wcet, tasks[k].period });
+        ranked.push_back({ tasks[result->order[k]].wcet, tasks[result->order[k]].period });
+    }
+
+    result->utilization = rms_utilization(tasks, count);
+    bool overloaded = result->utilization > 1;
+    bool needsExact = !overloaded && result->utilization > liuLaylandBound(count);
+    decideSet(ranked, overloaded, needsExact, setHyperPeriod(inOrder), windowLimit ? windowLimit : DEFAULT_WINDOW_LIMIT, result->set);
+
+    result->verdict = overloaded ? RMS_OVERLOADED : !needsExact ? RMS_UNDER_BOUND : result->set.schedulable ? RMS_EXACT_MET : RMS_EXACT_MISSED;
+    if (result->set.schedulable && !(flags & RMS_NO_SCHEDULE))
+    {
+        simulateSet(ranked, result->set);
+    }
+    return RMS_OK;
+}
+
+extern "C"
+{
+
+int rms_abi_version(void)
+{
+    return RMS_ABI_VERSION;
+}
+
+size_t rms_parse(const char* text, size_t length, rms_task* tasks, size_t capacity)
+{
+    if (!text)
+    {
+        return 0;
+    }
+
+    FieldCursor fields(std::string_view(text, length));
+    std::string_view name;
+    int wcet, period;
+    size_t count = 0;
+    while (fields.word(name) && fields.integer(wcet) && fields.integer(period))
+    {
+        if (count < capacity && tasks)
+        {
+            tasks[count] = { name.data(), name.size(), wcet, period };
+        }
+        count++;
+    }
+    return count;
+}
+
+int64_t rms_hyperperiod(const rms_task* tasks, size_t count)
+{
+    long long hyperPeriod = count ? tasks[0].period : 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        hyperPeriod = checkedLcm(hyperPeriod, tasks[k].period);
+    }
+    return hyperPeriod;
+}
+
+double rms_utilization(const rms_task* tasks, size_t count)
+{
+    double utilization = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        utilization = utilization + (static_cast<double>(tasks[k].wcet) / static_cast<double>(tasks[k].period));
+    }
+    return utilization;
+}
+
+double rms_bound(size_t count)
+{
+    return liuLaylandBound(count);
+}
+
+int rms_analyze(const rms_task* tasks, size_t count, int64_t window_limit, int flags, rms_result** result)
+{
+    if (!result)
+    {
+        return RMS_INVALID_ARGUMENT;
+    }
+    *result = NULL;
+    if ((!tasks && count) || window_limit < 0)
+    {
+        return RMS_INVALID_ARGUMENT;
+    }
+
+    // nothing may get out of here as an exception, a C caller can't catch it
+    rms_result* analyzed = new (std::nothrow) rms_result;
+    if (!analyzed)
+    {
+        return RMS_OUT_OF_MEMORY;
+    }
+    int status;
+    try
+    {
+        status = analyze(tasks, count, window_limit, flags, analyzed);
+    }
+    catch (const std::bad_alloc&)
+    {
+        status = RMS_OUT_OF_MEMORY;
+    }
+    catch (...)
+    {
+        status = RMS_INTERNAL_ERROR;
+    }
+
+    if (status != RMS_OK)
+    {
+        delete analyzed;
+        return status;
+    }
+    *result = analyzed;
+    return RMS_OK;
+}
+
+void rms_result_free(rms_result* result)
+{
+    delete result;
+}
+
+rms_verdict rms_result_verdict(const rms_result* result)
+{
+    return result->verdict;
+}
+
+int rms_result_schedulable(const rms_result* result)
+{
+    return result->set.schedulable;
+}
+
+double rms_result_utilization(const rms_result* result)
+{
+    return result->utilization;
+}
+
+int64_t rms_result_hyperperiod(const rms_result* result)
+{
+    return result->set.hyperPeriod;
+}
+
+int64_t rms_result_window(const rms_result* result)
+{
+    return result->set.window;
+}
+
+size_t rms_result_responses(const rms_result* result, int64_t* responses, size_t capacity)
+{
+    const std::vector<long long>& ranked = result->set.responses;
+    for (size_t k = 0; k < ranked.size() && responses; k++)
+    {
+        if (result->order[k] < capacity)
+        {
+            responses[result->order[k]] = ranked[k];
+        }
+    }
+    return ranked.size();
+}
+
+size_t rms_result_segments(const rms_result* result, rms_segment* segments, size_t capacity)
+{
+    const std::vector<Segment>& schedule = result->set.segments;
+    for (size_t k = 0; k < schedule.size() && k < capacity && segments; k++)
+    {
+        int task = schedule[k].task;
+        segments[k] = { task == IDLE ? -1 : (int64_t)result->order[task], schedule[k].start, schedule[k].length };
+    }
+    return schedule.size();
+}
+
+}
@@ -0,0 +1,126 @@
+#ifndef LIBRMS_H
+#define LIBRMS_H
+
+// rate monotonic analysis as a library with a C interface, for programs that want to ask about a
+// task set without starting PA3 and piping text through it. the analysis is the one PA3 runs
+// (Analysis.h): utilization against 1 and the liu-layland bound, the exact response time test
+// when the bound can't decide, and the schedule over the hyperperiod (or the level-1 busy period
+// when that is too long). nothing in here keeps any state, any thread can call anything.
+//
+//   g++ -std=c++17 -O2 -fPIC -shared -fvisibility=hidden librms.cpp -o librms.so
+//
+//   rms_task tasks[16];
+//   size_t n = rms_parse(line, strlen(line), tasks, 16);
+//   rms_result* result;
+//   if (n <= 16 && rms_analyze(tasks, n, 0, 0, &result) == RMS_OK)
+//   {
+//       if (rms_result_schedulable(result)) ...
+//       rms_result_free(result);
+//   }
+//
+// the layout of the structs and the meaning of the functions only ever change together with
+// RMS_ABI_VERSION
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define RMS_API __attribute__((visibility("default")))
+#else
+#define RMS_API
+#endif
+
+#define RMS_ABI_VERSION 1
+
+// what rms_hyperperiod gives when the lcm of the periods doesn't fit in 64 bits
+#define RMS_HYPERPERIOD_OVERFLOW (-1)
+
+// rms_analyze return values
+#define RMS_OK 0
+#define RMS_INVALID_TASK (-1)     // a wcet under 0, a period under 1, a wcet or period over INT_MAX,
+                                  // or a name that is NULL but not empty
+#define RMS_INVALID_ARGUMENT (-2) // no result pointer, no tasks array for count tasks, a negative window limit
+#define RMS_OUT_OF_MEMORY (-3)
+#define RMS_INTERNAL_ERROR (-4)   // anything else that went wrong inside the analysis
+
+// rms_analyze flags
+#define RMS_NO_SCHEDULE 1 // decide the set but don't simulate it
+
+// the name doesn't have to end in a 0, and is only read during the call it is passed to
+typedef struct rms_task
+{
+    const char* name;
+    size_t name_length;
+    int64_t wcet;
+    int64_t period;
+} rms_task;
+
+// task runs for length time units from start. task is an index into the array that was analyzed,
+// or -1 for idle
+typedef struct rms_segment
+{
+    int64_t task;
+    int64_t start;
+    int64_t length;
+} rms_segment;
+
+typedef enum rms_verdict
+{
+    RMS_UNDER_BOUND = 0,  // utilization at most the liu-layland bound
+    RMS_EXACT_MET = 1,    // over the bound, and every response time is within its period
+    RMS_EXACT_MISSED = 2, // over the bound, and some task misses its deadline
+    RMS_OVERLOADED = 3    // utilization over 1
+} rms_verdict;
+
+typedef struct rms_result rms_result;
+
+// RMS_ABI_VERSION of the library that is loaded
+RMS_API int rms_abi_version(void);
+
+// reads a line of input the way PA3 does, name wcet period repeated, up to the first field that
+// doesn't fit. the names point into text. returns how many tasks the line has; only the first
+// capacity of them are written, so a return over capacity means a bigger array is needed
+RMS_API size_t rms_parse(const char* text, size_t length, rms_task* tasks, size_t capacity);
+
+// the lcm of the periods, RMS_HYPERPERIOD_OVERFLOW past 64 bits, 0 for no tasks
+RMS_API int64_t rms_hyperperiod(const rms_task* tasks, size_t count);
+
+// sum of wcet / period, in the order the tasks are given
+RMS_API double rms_utilization(const rms_task* tasks, size_t count);
+
+// the liu-layland bound n(2^(1/n) - 1)
+RMS_API double rms_bound(size_t count);
+
+// analyzes count tasks. priorities are rate monotonic, ties in period going by name. a
+// hyperperiod over window_limit (0 for PA3's default) only gets the level-1 busy period
+// simulated. on RMS_OK *result has to be freed with rms_result_free, otherwise it is NULL
+RMS_API int rms_analyze(const rms_task* tasks, size_t count, int64_t window_limit, int flags, rms_result** result);
+
+RMS_API void rms_result_free(rms_result* result);
+
+RMS_API rms_verdict rms_result_verdict(const rms_result* result);
+RMS_API int rms_result_schedulable(const rms_result* result);
+RMS_API double rms_result_utilization(const rms_result* result);
+RMS_API int64_t rms_result_hyperperiod(const rms_result* result);
+
+// how much of the timeline the schedule covers, 0 if the set isn't schedulable
+RMS_API int64_t rms_result_window(const rms_result* result);
+
+// worst case response times in the order the tasks were given, only there when the response time
+// test ran (RMS_EXACT_MET, RMS_EXACT_MISSED). a response over the task's period is a miss, and
+// the test stopped counting there. copies up to capacity of them, returns how many there are
+RMS_API size_t rms_result_responses(const rms_result* result, int64_t* responses, size_t capacity);
+
+// the schedule, consecutive runs of the same task glued together. empty when the set isn't
+// schedulable or RMS_NO_SCHEDULE was passed. copies up to capacity, returns how many there are
+RMS_API size_t rms_result_segments(const rms_result* result, rms_segment* segments, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif